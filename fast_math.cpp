@@ -0,0 +1,18 @@
+#include "fast_math.h"
+
+void poly_power_fast_math(const float* x, float* out, size_t n) {
+	const float* c = poly_coeffs;
+	for (size_t i = 0; i < n; ++i) {
+		const float v = x[i];
+		out[i] = c[0] + c[1] * v + c[2] * v * v + c[3] * v * v * v
+		       + c[4] * v * v * v * v + c[5] * v * v * v * v * v;
+	}
+}
+
+void poly_horner_fast_math(const float* x, float* out, size_t n) {
+	const float* c = poly_coeffs;
+	for (size_t i = 0; i < n; ++i) {
+		const float v = x[i];
+		out[i] = ((((c[5] * v + c[4]) * v + c[3]) * v + c[2]) * v + c[1]) * v + c[0];
+	}
+}
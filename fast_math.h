@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstddef>
+
+// Degree-5 Taylor polynomial of exp(x), lowest order first
+constexpr float poly_coeffs[6] = { 1.0f, 1.0f, 1.0f / 2, 1.0f / 6, 1.0f / 24, 1.0f / 120 };
+
+// These kernels live in fast_math.cpp, the only translation unit compiled with
+// -ffast-math (see CMakeLists.txt), so the compiler is free to reassociate,
+// contract into FMA and ignore NaN/Inf/signed-zero semantics in them alone.
+void poly_power_fast_math(const float* x, float* out, size_t n);
+void poly_horner_fast_math(const float* x, float* out, size_t n);
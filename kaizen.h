@@ -24,8 +24,16 @@
 
 #pragma once 
 
+// Kaizen needs C++20 (concepts, <ranges>, <bit>). The feature-test checks further down
+// choose between alternatives for what some C++20 compilers still lack, such as the
+// class-type template parameters of zen::ct_regex.
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) < 202002L
+    #error "kaizen.h REQUIRES C++20 OR LATER"
+#endif
+
 // Since the order of these #includes doesn't matter,
 // they're sorted in descending length for aesthetics
+#include <condition_variable>
 #include <unordered_map>
 #include <unordered_set>
 #include <forward_list>
@@ -38,25 +46,44 @@
 #include <optional>
 #include <iostream>
 #include <iterator>
+#include <charconv>
 #include <fstream>
 #include <sstream>
 #include <ostream>
 #include <utility>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <random>
 #include <chrono>
 #include <atomic>
+#include <thread>
+#include <memory>
+#include <limits>
+#include <cstdio>
+#include <ranges>
 #include <regex>
+#include <mutex>
 #include <array>
 #include <deque>
 #include <ctime>
 #include <queue>
 #include <stack>
 #include <list>
+#include <bit>
+#include <new>
 #include <set>
 #include <map>
 
+// SSE2 is part of the x86-64 baseline, so its paths need no extra compiler flags
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ZEN_HAS_SSE2 1
+    #include <emmintrin.h>
+#else
+    #define ZEN_HAS_SSE2 0
+#endif
+
 namespace zen {
 
 ///////////////////////////////////////////////////////////////////////////////////////////// MISC
@@ -72,6 +99,127 @@ inline auto timestamp() {
     return timestr.substr(0, timestr.length() - 1);
 }
 
+namespace internal {
+    // Compiling a std::regex costs far more than most searches with it, so patterns that
+    // arrive as strings are compiled once per thread and reused. The returned reference
+    // is only guaranteed to stay valid until the next call on the same thread.
+    inline const std::regex& cached_regex(const std::string& pattern)
+    {
+        thread_local std::unordered_map<std::string, std::regex> cache;
+
+        auto it = cache.find(pattern);
+        if (it == cache.end()) {
+            if (cache.size() >= 256)
+                cache.clear(); // keep an unbounded stream of distinct patterns from growing it forever
+            it = cache.emplace(pattern, std::regex(pattern)).first;
+        }
+        return it->second;
+    }
+} // namespace internal
+
+namespace internal {
+    // Element types whose operator== is a plain compare of their value, so it can be done
+    // 16 bytes at a time. bool is left out, since any non-zero byte pattern reads as true.
+    template<class T>
+    constexpr bool is_simd_searchable_v =
+        (std::is_integral_v<T> && !std::is_same_v<T, bool> && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8))
+        || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+#if ZEN_HAS_SSE2
+    template<class T>
+    inline __m128i simd_splat(const T x)
+    {
+        if constexpr (std::is_same_v<T, float>)       return _mm_castps_si128(_mm_set1_ps(x));
+        else if constexpr (std::is_same_v<T, double>) return _mm_castpd_si128(_mm_set1_pd(x));
+        else if constexpr (sizeof(T) == 1)            return _mm_set1_epi8(static_cast<char>(x));
+        else if constexpr (sizeof(T) == 2)            return _mm_set1_epi16(static_cast<short>(x));
+        else if constexpr (sizeof(T) == 4)            return _mm_set1_epi32(static_cast<int>(x));
+        else                                          return _mm_set1_epi64x(static_cast<long long>(x));
+    }
+
+    // One bit per byte of the 16 loaded, set for every byte of every element equal to x.
+    // Floats are compared as floats, so NaN matches nothing and -0.0 matches 0.0, as with ==.
+    template<class T>
+    inline unsigned simd_match_mask(const T* p, const __m128i x)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i eq;
+        if constexpr (std::is_same_v<T, float>)       eq = _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(v), _mm_castsi128_ps(x)));
+        else if constexpr (std::is_same_v<T, double>) eq = _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(v), _mm_castsi128_pd(x)));
+        else if constexpr (sizeof(T) == 1)            eq = _mm_cmpeq_epi8(v, x);
+        else if constexpr (sizeof(T) == 2)            eq = _mm_cmpeq_epi16(v, x);
+        else if constexpr (sizeof(T) == 4)            eq = _mm_cmpeq_epi32(v, x);
+        else {
+            // SSE2 has no 64-bit compare: both 32-bit halves have to match
+            const __m128i eq32 = _mm_cmpeq_epi32(v, x);
+            eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, _MM_SHUFFLE(2, 3, 0, 1)));
+        }
+        return static_cast<unsigned>(_mm_movemask_epi8(eq));
+    }
+#endif
+
+    // std::find for contiguous arrays of arithmetic types, 64 bytes per loop iteration
+    template<class T>
+    const T* simd_find(const T* first, const T* last, const T x)
+    {
+#if ZEN_HAS_SSE2
+        constexpr size_t lanes = 16 / sizeof(T);
+        const __m128i    splat = simd_splat(x);
+        for (; last - first >= static_cast<std::ptrdiff_t>(4 * lanes); first += 4 * lanes) {
+            const unsigned m0 = simd_match_mask(first, splat),             m1 = simd_match_mask(first + lanes, splat);
+            const unsigned m2 = simd_match_mask(first + 2 * lanes, splat), m3 = simd_match_mask(first + 3 * lanes, splat);
+            const uint64_t mask = m0 | (uint64_t(m1) << 16) | (uint64_t(m2) << 32) | (uint64_t(m3) << 48);
+            if (mask != 0)
+                return first + std::countr_zero(mask) / sizeof(T);
+        }
+        for (; last - first >= static_cast<std::ptrdiff_t>(lanes); first += lanes)
+            if (const unsigned mask = simd_match_mask(first, splat); mask != 0)
+                return first + std::countr_zero(mask) / sizeof(T);
+#endif
+        for (; first != last; ++first)
+            if (*first == x)
+                return first;
+        return last;
+    }
+
+    // std::count for contiguous arrays of arithmetic types
+    template<class T>
+    size_t simd_count(const T* first, const T* last, const T x)
+    {
+        size_t matches = 0;
+#if ZEN_HAS_SSE2
+        constexpr size_t lanes = 16 / sizeof(T);
+        const __m128i    splat = simd_splat(x);
+        size_t matching_bytes = 0;
+        for (; last - first >= static_cast<std::ptrdiff_t>(4 * lanes); first += 4 * lanes) {
+            const unsigned m0 = simd_match_mask(first, splat),             m1 = simd_match_mask(first + lanes, splat);
+            const unsigned m2 = simd_match_mask(first + 2 * lanes, splat), m3 = simd_match_mask(first + 3 * lanes, splat);
+            matching_bytes += static_cast<size_t>(std::popcount(m0 | (uint64_t(m1) << 16) | (uint64_t(m2) << 32) | (uint64_t(m3) << 48)));
+        }
+        for (; last - first >= static_cast<std::ptrdiff_t>(lanes); first += lanes)
+            matching_bytes += static_cast<size_t>(std::popcount(simd_match_mask(first, splat)));
+        matches = matching_bytes / sizeof(T);
+#endif
+        for (; first != last; ++first)
+            matches += *first == x;
+        return matches;
+    }
+
+    // std::find, switching to simd_find when the elements are contiguous and arithmetic
+    template<class It, class T>
+    It find_value(It first, It last, const T& x)
+    {
+        if constexpr (std::contiguous_iterator<It> && is_simd_searchable_v<std::iter_value_t<It>>
+                      && std::is_same_v<std::iter_value_t<It>, T>) {
+            const T* const begin = std::to_address(first);
+            return first + (simd_find(begin, begin + (last - first), x) - begin);
+        }
+        else {
+            return std::find(first, last, x);
+        }
+    }
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////////////////// SERIALIZATION
 
 template <class T> constexpr bool is_string_like(); // forward declaration
@@ -367,7 +515,7 @@ public:
     {
         return std::find_if(my::begin(), my::end(), p) != my::end();
     }
-    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
+    bool contains(const T& x) const { return internal::find_value(my::begin(), my::end(), x) != my::end(); }
 
     bool is_empty() const { return my::empty(); }
 
@@ -443,7 +591,8 @@ public:
         std::string line;
         int loc = 0;
         while (std::getline(file, line)) {
-            if (std::regex_match(line, std::regex(R"(^\s*[^/\*\\].*\r?$)"))) {
+            static const std::regex rx_code_line(R"(^\s*[^/\*\\].*\r?$)");
+            if (std::regex_match(line, rx_code_line)) {
                 ++loc;
             }
         }
@@ -453,7 +602,7 @@ public:
 private:
     bool matches_any(const std::string& ext, const std::vector<std::string>& extensions) const {
         for (const auto& pattern : extensions) {
-            if (std::regex_match(ext, std::regex(pattern))) {
+            if (std::regex_match(ext, internal::cached_regex(pattern))) {
                 return true;
             }
         }
@@ -573,6 +722,569 @@ private:
     arguments          args_accepted_;
 };
 
+///////////////////////////////////////////////////////////////////////////////////////////// zen::ct_regex
+
+// Class-type template parameters are a C++20 feature that clang supports without advertising it
+#if __cpp_nontype_template_args >= 201911L || (defined(__clang__) && __clang_major__ >= 13)
+    #define ZEN_HAS_CT_REGEX 1
+#else
+    #define ZEN_HAS_CT_REGEX 0
+#endif
+
+#if ZEN_HAS_CT_REGEX
+// A string literal usable as a template argument
+template<size_t N>
+struct fixed_string {
+    char chars[N] = {};
+
+    constexpr fixed_string(const char (&s)[N]) { std::copy_n(s, N, chars); }
+
+    constexpr size_t size() const { return N - 1; }
+};
+
+namespace internal {
+    struct ct_charset {
+        uint64_t bits[4] = {};
+
+        constexpr void set(unsigned char c)        { bits[c >> 6] |= uint64_t(1) << (c & 63); }
+        constexpr bool test(unsigned char c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+
+        constexpr void set_range(unsigned char lo, unsigned char hi)
+        {
+            for (int c = lo; c <= hi; ++c)
+                set(static_cast<unsigned char>(c));
+        }
+
+        constexpr void merge(const ct_charset& other) { for (int i = 0; i < 4; ++i) bits[i] |= other.bits[i]; }
+        constexpr void invert()                       { for (int i = 0; i < 4; ++i) bits[i] = ~bits[i]; }
+    };
+
+    inline constexpr int ct_max_nfa_states = 256;
+    inline constexpr int ct_max_dfa_states = 64;
+
+    // Thompson NFA: every node either consumes one char of 'chars' and moves to 'next',
+    // or has up to two epsilon edges
+    struct ct_nfa {
+        struct node {
+            ct_charset chars;
+            bool       consumes = false;
+            int        next     = -1;
+            int        eps[2]   = { -1, -1 };
+        };
+
+        node nodes[ct_max_nfa_states] = {};
+        int  count  = 0;
+        int  start  = 0;
+        int  accept = 0;
+
+        constexpr int add()
+        {
+            if (count == ct_max_nfa_states)
+                throw std::length_error("CT_REGEX PATTERN IS TOO LARGE");
+            return count++;
+        }
+    };
+
+    // Recursive descent over the ECMAScript subset that a DFA can match without
+    // backtracking: literals, escapes (\d \w \s and their negations), '.', [classes],
+    // (groups), '|', and the quantifiers * + ? {n} {n,} {n,m}. Anchors, backreferences,
+    // lookarounds and lazy quantifiers are rejected at compile time.
+    class ct_parser {
+    public:
+        constexpr ct_parser(const char* pattern, size_t size, ct_nfa& nfa) : p_(pattern), n_(size), nfa_(nfa) {}
+
+        constexpr void parse()
+        {
+            const fragment f = parse_alternation();
+            if (pos_ != n_)
+                throw std::invalid_argument("CT_REGEX PATTERN HAS AN UNMATCHED ')'");
+            nfa_.start  = f.start;
+            nfa_.accept = f.end;
+        }
+
+    private:
+        struct fragment { int start, end; }; // 'end' has no edges yet
+
+        constexpr bool at_end() const { return pos_ == n_; }
+        constexpr char peek()   const { return p_[pos_]; }
+
+        constexpr fragment empty()
+        {
+            const int s = nfa_.add(), e = nfa_.add();
+            nfa_.nodes[s].eps[0] = e;
+            return { s, e };
+        }
+
+        constexpr fragment one_of(const ct_charset& chars)
+        {
+            const int s = nfa_.add(), e = nfa_.add();
+            nfa_.nodes[s].chars    = chars;
+            nfa_.nodes[s].consumes = true;
+            nfa_.nodes[s].next     = e;
+            return { s, e };
+        }
+
+        constexpr fragment concat(fragment a, fragment b)
+        {
+            nfa_.nodes[a.end].eps[0] = b.start;
+            return { a.start, b.end };
+        }
+
+        constexpr fragment either(fragment a, fragment b)
+        {
+            const int s = nfa_.add(), e = nfa_.add();
+            nfa_.nodes[s].eps[0] = a.start;
+            nfa_.nodes[s].eps[1] = b.start;
+            nfa_.nodes[a.end].eps[0] = e;
+            nfa_.nodes[b.end].eps[0] = e;
+            return { s, e };
+        }
+
+        constexpr fragment optional(fragment a) { return either(a, empty()); }
+
+        constexpr fragment star(fragment a)
+        {
+            const int s = nfa_.add(), e = nfa_.add();
+            nfa_.nodes[s].eps[0] = a.start;
+            nfa_.nodes[s].eps[1] = e;
+            nfa_.nodes[a.end].eps[0] = a.start;
+            nfa_.nodes[a.end].eps[1] = e;
+            return { s, e };
+        }
+
+        constexpr fragment parse_alternation()
+        {
+            fragment f = parse_concatenation();
+            while (!at_end() && peek() == '|') {
+                ++pos_;
+                f = either(f, parse_concatenation());
+            }
+            return f;
+        }
+
+        constexpr fragment parse_concatenation()
+        {
+            fragment f = empty();
+            while (!at_end() && peek() != '|' && peek() != ')')
+                f = concat(f, parse_repetition());
+            return f;
+        }
+
+        constexpr fragment parse_repetition()
+        {
+            const size_t atom_begin = pos_;
+            fragment atom = parse_atom();
+            if (at_end())
+                return atom;
+
+            size_t min = 0, max = 0;
+            bool unbounded = false;
+            switch (peek()) {
+                case '*': ++pos_; return star(atom);
+                case '?': ++pos_; atom = optional(atom); break;
+                case '+': ++pos_; atom = concat(atom, star(copy_atom(atom_begin))); break;
+                case '{':
+                    ++pos_;
+                    min = parse_number();
+                    max = min;
+                    if (!at_end() && peek() == ',') {
+                        ++pos_;
+                        unbounded = at_end() || peek() == '}';
+                        if (!unbounded)
+                            max = parse_number();
+                    }
+                    expect('}');
+                    if (!unbounded && max < min)
+                        throw std::invalid_argument("CT_REGEX REPETITION RANGE IS OUT OF ORDER");
+                    atom = repeat(atom, atom_begin, min, max, unbounded);
+                    break;
+                default:
+                    return atom;
+            }
+
+            if (!at_end() && (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{'))
+                throw std::invalid_argument("CT_REGEX LAZY OR STACKED QUANTIFIERS ARE NOT SUPPORTED");
+            return atom;
+        }
+
+        // A repeated atom needs fresh NFA nodes per copy, so the atom is simply parsed again
+        constexpr fragment copy_atom(size_t atom_begin)
+        {
+            const size_t resume = pos_;
+            pos_ = atom_begin;
+            const fragment f = parse_atom();
+            pos_ = resume;
+            return f;
+        }
+
+        constexpr fragment repeat(fragment atom, size_t atom_begin, size_t min, size_t max, bool unbounded)
+        {
+            fragment f = empty();
+            bool first = true;
+            const auto next_copy = [&] {
+                if (first) {
+                    first = false;
+                    return atom;
+                }
+                return copy_atom(atom_begin);
+            };
+
+            for (size_t i = 0; i < min; ++i)
+                f = concat(f, next_copy());
+            if (unbounded)
+                return concat(f, star(next_copy()));
+            for (size_t i = min; i < max; ++i)
+                f = concat(f, optional(next_copy()));
+            return f;
+        }
+
+        constexpr size_t parse_number()
+        {
+            if (at_end() || peek() < '0' || peek() > '9')
+                throw std::invalid_argument("CT_REGEX EXPECTED A NUMBER IN {}");
+            size_t value = 0;
+            while (!at_end() && '0' <= peek() && peek() <= '9')
+                value = value * 10 + static_cast<size_t>(p_[pos_++] - '0');
+            return value;
+        }
+
+        constexpr void expect(char c)
+        {
+            if (at_end() || peek() != c)
+                throw std::invalid_argument("CT_REGEX PATTERN IS MALFORMED");
+            ++pos_;
+        }
+
+        constexpr fragment parse_atom()
+        {
+            if (at_end())
+                throw std::invalid_argument("CT_REGEX PATTERN ENDS UNEXPECTEDLY");
+
+            ct_charset chars;
+            switch (const char c = p_[pos_++]) {
+                case '(': {
+                    if (!at_end() && peek() == '?') { // only (?:...) is supported
+                        ++pos_;
+                        expect(':');
+                    }
+                    const fragment f = parse_alternation();
+                    expect(')');
+                    return f;
+                }
+                case '[':
+                    chars = parse_class();
+                    break;
+                case '.':
+                    chars.invert(); // any char but a line terminator
+                    chars.bits[0] &= ~((uint64_t(1) << '\n') | (uint64_t(1) << '\r'));
+                    break;
+                case '\\':
+                    chars = parse_escape();
+                    break;
+                case '*': case '+': case '?': case '{':
+                    throw std::invalid_argument("CT_REGEX QUANTIFIER HAS NOTHING TO REPEAT");
+                case '^': case '$':
+                    throw std::invalid_argument("CT_REGEX ANCHORS ARE NOT SUPPORTED");
+                default:
+                    chars.set(static_cast<unsigned char>(c));
+            }
+            return one_of(chars);
+        }
+
+        constexpr ct_charset parse_escape()
+        {
+            if (at_end())
+                throw std::invalid_argument("CT_REGEX PATTERN ENDS IN A BACKSLASH");
+
+            ct_charset chars;
+            const char c = p_[pos_++];
+            switch (c) {
+                case 'd': case 'D': chars.set_range('0', '9'); break;
+                case 's': case 'S': chars.set_range('\t', '\r'); chars.set(' '); break;
+                case 'w': case 'W':
+                    chars.set_range('a', 'z');
+                    chars.set_range('A', 'Z');
+                    chars.set_range('0', '9');
+                    chars.set('_');
+                    break;
+                case 'n': chars.set('\n'); break;
+                case 'r': chars.set('\r'); break;
+                case 't': chars.set('\t'); break;
+                case 'b': case 'B':
+                    throw std::invalid_argument("CT_REGEX WORD BOUNDARIES ARE NOT SUPPORTED");
+                default:
+                    if ('0' <= c && c <= '9')
+                        throw std::invalid_argument("CT_REGEX BACKREFERENCES ARE NOT SUPPORTED");
+                    chars.set(static_cast<unsigned char>(c));
+            }
+            if (c == 'D' || c == 'S' || c == 'W')
+                chars.invert();
+            return chars;
+        }
+
+        constexpr ct_charset parse_class()
+        {
+            ct_charset chars;
+            const bool negated = !at_end() && peek() == '^';
+            if (negated)
+                ++pos_;
+
+            // As in ECMAScript, "[]" is an empty class that matches nothing and "[^]" matches any char
+            while (at_end() || peek() != ']') {
+                if (at_end())
+                    throw std::invalid_argument("CT_REGEX CHARACTER CLASS IS MISSING ']'");
+
+                if (peek() == '\\') {
+                    ++pos_;
+                    const ct_charset escaped = parse_escape();
+                    chars.merge(escaped);
+                    continue;
+                }
+
+                const unsigned char lo = static_cast<unsigned char>(p_[pos_++]);
+                if (pos_ + 1 < n_ && peek() == '-' && p_[pos_ + 1] != ']') {
+                    const unsigned char hi = static_cast<unsigned char>(p_[pos_ + 1]);
+                    if (hi < lo)
+                        throw std::invalid_argument("CT_REGEX CHARACTER RANGE IS OUT OF ORDER");
+                    chars.set_range(lo, hi);
+                    pos_ += 2;
+                } else {
+                    chars.set(lo);
+                }
+            }
+            ++pos_; // ']'
+
+            if (negated)
+                chars.invert();
+            return chars;
+        }
+
+        const char* p_;
+        size_t      n_;
+        size_t      pos_ = 0;
+        ct_nfa&     nfa_;
+    };
+
+    struct ct_nfa_set {
+        uint64_t bits[ct_max_nfa_states / 64] = {};
+
+        constexpr void set(int i)        { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+        constexpr bool test(int i) const { return (bits[i >> 6] >> (i & 63)) & 1; }
+
+        constexpr bool empty() const
+        {
+            for (const uint64_t b : bits)
+                if (b)
+                    return false;
+            return true;
+        }
+
+        constexpr bool operator==(const ct_nfa_set&) const = default;
+    };
+
+    // The DFA as built, with room for the largest supported pattern
+    struct ct_dfa_draft {
+        uint8_t class_of[256]                        = {};
+        uint8_t next[ct_max_dfa_states][256]         = {}; // [state][class], state 0 is dead
+        bool    accepting[ct_max_dfa_states]         = {};
+        int     classes                              = 0;
+        int     states                               = 1;
+    };
+
+    // The epsilon edges of an NFA as adjacency lists, either as built or all reversed
+    struct ct_eps_edges {
+        int first[ct_max_nfa_states + 1] = {}; // node i's edges are to[first[i]] .. to[first[i + 1] - 1]
+        int to[2 * ct_max_nfa_states]    = {};
+
+        constexpr ct_eps_edges(const ct_nfa& nfa, bool reversed)
+        {
+            for (int i = 0; i < nfa.count; ++i)
+                for (const int j : nfa.nodes[i].eps)
+                    if (j >= 0)
+                        ++first[(reversed ? j : i) + 1];
+            for (int i = 0; i < nfa.count; ++i)
+                first[i + 1] += first[i];
+
+            int filled[ct_max_nfa_states] = {};
+            for (int i = 0; i < nfa.count; ++i)
+                for (const int j : nfa.nodes[i].eps)
+                    if (j >= 0) {
+                        const int from = reversed ? j : i;
+                        to[first[from] + filled[from]++] = reversed ? i : j;
+                    }
+        }
+    };
+
+    constexpr void ct_close(const ct_nfa& nfa, const ct_eps_edges& edges, ct_nfa_set& set)
+    {
+        int stack[ct_max_nfa_states] = {};
+        int top = 0;
+        for (int i = 0; i < nfa.count; ++i)
+            if (set.test(i))
+                stack[top++] = i;
+
+        while (top > 0) {
+            const int from = stack[--top];
+            for (int e = edges.first[from]; e < edges.first[from + 1]; ++e) {
+                const int to = edges.to[e];
+                if (!set.test(to)) {
+                    set.set(to);
+                    stack[top++] = to;
+                }
+            }
+        }
+    }
+
+    // forward:           matches the pattern from the first char, as match() needs
+    // reverse_unanchored: reads the text backwards and accepts wherever a match of the
+    //                    pattern begins, whatever follows it (the reversed pattern with '.*' after it)
+    enum class ct_direction { forward, reverse_unanchored };
+
+    // Parses the pattern into an NFA and turns it into a DFA by subset construction.
+    // Chars that no NFA edge tells apart share a class, which keeps the table small.
+    constexpr ct_dfa_draft ct_compile(const char* pattern, size_t size, ct_direction direction = ct_direction::forward)
+    {
+        ct_nfa nfa;
+        ct_parser(pattern, size, nfa).parse();
+
+        ct_dfa_draft dfa;
+        uint8_t representative[256] = {};
+        for (int c = 0; c < 256; ++c) {
+            int cls = 0;
+            for (; cls < dfa.classes; ++cls) {
+                bool same = true;
+                for (int i = 0; i < nfa.count && same; ++i)
+                    if (nfa.nodes[i].consumes)
+                        same = nfa.nodes[i].chars.test(static_cast<unsigned char>(c)) == nfa.nodes[i].chars.test(representative[cls]);
+                if (same)
+                    break;
+            }
+            if (cls == dfa.classes)
+                representative[dfa.classes++] = static_cast<uint8_t>(c);
+            dfa.class_of[c] = static_cast<uint8_t>(cls);
+        }
+
+        const bool reversed = direction == ct_direction::reverse_unanchored;
+        const ct_eps_edges edges(nfa, reversed);
+
+        ct_nfa_set initial;
+        initial.set(reversed ? nfa.accept : nfa.start);
+        ct_close(nfa, edges, initial);
+
+        ct_nfa_set sets[ct_max_dfa_states] = {};
+        sets[1] = initial;
+        dfa.states = 2;
+
+        for (int state = 1; state < dfa.states; ++state) {
+            dfa.accepting[state] = sets[state].test(reversed ? nfa.start : nfa.accept);
+
+            for (int cls = 0; cls < dfa.classes; ++cls) {
+                ct_nfa_set moved;
+                for (int i = 0; i < nfa.count; ++i) {
+                    const auto& node = nfa.nodes[i];
+                    if (node.consumes && node.chars.test(representative[cls])) {
+                        if (!reversed && sets[state].test(i))
+                            moved.set(node.next);
+                        if (reversed && sets[state].test(node.next))
+                            moved.set(i);
+                    }
+                }
+                ct_close(nfa, edges, moved);
+                if (reversed) // a match may begin at any later position too
+                    for (int w = 0; w < ct_max_nfa_states / 64; ++w)
+                        moved.bits[w] |= initial.bits[w];
+                if (moved.empty())
+                    continue; // stays 0, the dead state
+
+                int target = 1;
+                while (target < dfa.states && !(sets[target] == moved))
+                    ++target;
+                if (target == dfa.states) {
+                    if (dfa.states == ct_max_dfa_states)
+                        throw std::length_error("CT_REGEX PATTERN NEEDS TOO MANY DFA STATES");
+                    sets[dfa.states++] = moved;
+                }
+                dfa.next[state][cls] = static_cast<uint8_t>(target);
+            }
+        }
+        return dfa;
+    }
+
+    // The same DFA trimmed to its actual size
+    template<int States, int Classes>
+    struct ct_dfa {
+        uint8_t class_of[256]             = {};
+        uint8_t next[States][Classes]     = {};
+        bool    accepting[States]         = {};
+
+        constexpr explicit ct_dfa(const ct_dfa_draft& draft)
+        {
+            std::copy_n(draft.class_of, 256, class_of);
+            for (int s = 0; s < States; ++s) {
+                std::copy_n(draft.next[s], Classes, next[s]);
+                accepting[s] = draft.accepting[s];
+            }
+        }
+    };
+} // namespace internal
+
+// A regular expression compiled into a DFA at compile time, so matching it is a single
+// table lookup per char, with no backtracking and no runtime compilation. search() makes
+// two such passes (see below), so it is linear in the length of the text too.
+// Example: zen::ct_regex<R"(\d+\.\d+\.\d+\.\d+)">::match("8.2.3.4567") == true
+// Invalid or unsupported patterns fail to compile (see internal::ct_parser for the syntax).
+// Unlike std::regex_search(), search() returns the leftmost-longest match.
+template<fixed_string Pattern>
+class ct_regex {
+    static constexpr internal::ct_dfa_draft draft_ = internal::ct_compile(Pattern.chars, Pattern.size());
+    static constexpr internal::ct_dfa<draft_.states, draft_.classes> dfa_{draft_};
+
+    static constexpr uint8_t step(uint8_t state, char c) { return dfa_.next[state][dfa_.class_of[static_cast<unsigned char>(c)]]; }
+
+    // The DFA search() runs backwards. A member class of a template is only instantiated
+    // where it is used, so match() alone never compiles it; it can need far more states
+    // than the forward DFA (e.g. "[ab]{6}a").
+    struct reverse {
+        static constexpr internal::ct_dfa_draft draft = internal::ct_compile(Pattern.chars, Pattern.size(), internal::ct_direction::reverse_unanchored);
+        static constexpr internal::ct_dfa<draft.states, draft.classes> dfa{draft};
+
+        static constexpr uint8_t step(uint8_t state, char c) { return dfa.next[state][dfa.class_of[static_cast<unsigned char>(c)]]; }
+    };
+
+public:
+    // True if the whole text matches, like std::regex_match()
+    static constexpr bool match(const std::string_view text)
+    {
+        uint8_t state = 1;
+        for (const char c : text)
+            if ((state = step(state, c)) == 0)
+                return false;
+        return dfa_.accepting[state];
+    }
+
+    // The leftmost-longest match in the text, if any. One backward pass of the reverse DFA
+    // finds the leftmost position where a match begins, then one forward pass from there
+    // finds where the longest one ends.
+    static constexpr std::optional<std::string_view> search(const std::string_view text)
+    {
+        uint8_t state = 1;
+        size_t  first = reverse::dfa.accepting[state] ? text.size() : std::string_view::npos;
+        for (size_t i = text.size(); i-- > 0;)
+            if (reverse::dfa.accepting[state = reverse::step(state, text[i])])
+                first = i;
+        if (first == std::string_view::npos)
+            return std::nullopt;
+
+        state = 1;
+        size_t last = first; // a match begins at 'first', so this is only ever extended
+        for (size_t i = first; i < text.size() && (state = step(state, text[i])) != 0; ++i)
+            if (dfa_.accepting[state])
+                last = i + 1;
+        return text.substr(first, last - first);
+    }
+};
+#endif // ZEN_HAS_CT_REGEX
+
 ///////////////////////////////////////////////////////////////////////////////////////////// CONCEPTS
 
 // ------------------------------------------------------------------------------------------ HasEmpty
@@ -703,6 +1415,210 @@ constexpr bool is_string_like() {
         || std::is_convertible<T, const char*>::value;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////// HASHING
+
+class string; // forward declaration
+
+namespace internal {
+    // 64x64 -> 128-bit multiply, the core of wyhash: *a gets the low half, *b the high one
+    inline void wy_mum(uint64_t* a, uint64_t* b)
+    {
+#if defined(__SIZEOF_INT128__)
+        const __uint128_t r = static_cast<__uint128_t>(*a) * *b;
+        *a = static_cast<uint64_t>(r);
+        *b = static_cast<uint64_t>(r >> 64);
+#else
+        const uint64_t ha = *a >> 32, hb = *b >> 32, la = static_cast<uint32_t>(*a), lb = static_cast<uint32_t>(*b);
+        const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+        uint64_t       lo = t + (rm1 << 32);
+        const uint64_t c  = (t < rl) + (lo < t);
+        *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+        *a = lo;
+#endif
+    }
+
+    inline uint64_t wy_mix(uint64_t a, uint64_t b) { wy_mum(&a, &b); return a ^ b; }
+
+    // Unaligned native-endian reads, so hash values differ between little and big endian machines
+    inline uint64_t wy_read8(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+    inline uint64_t wy_read4(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+    inline uint64_t wy_read3(const uint8_t* p, size_t k) { return (uint64_t(p[0]) << 16) | (uint64_t(p[k >> 1]) << 8) | p[k - 1]; }
+
+    inline constexpr uint64_t wy_secret[4] = {
+        0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+    };
+} // namespace internal
+
+// wyhash (final version 4), a fast non-cryptographic 64-bit hash: it reads 16 bytes per
+// step for short inputs and 48 bytes per step, in three independent lanes, for long ones.
+// It passes SMHasher, and Go's and Zig's standard hash functions derive from it.
+// It's NOT suitable for anything an attacker may tamper with (use a random seed there).
+// Example: uint64_t h = zen::wyhash(s.data(), s.size(), seed);
+inline uint64_t wyhash(const void* data, size_t len, uint64_t seed = 0)
+{
+    using namespace internal;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    seed ^= wy_mix(seed ^ wy_secret[0], wy_secret[1]);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            a = (wy_read4(p) << 32) | wy_read4(p + ((len >> 3) << 2));
+            b = (wy_read4(p + len - 4) << 32) | wy_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0) {
+            a = wy_read3(p, len);
+            b = 0;
+        }
+        else {
+            a = b = 0;
+        }
+    }
+    else {
+        size_t i = len;
+        if (i >= 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = wy_mix(wy_read8(p)      ^ wy_secret[1], wy_read8(p + 8)  ^ seed);
+                see1 = wy_mix(wy_read8(p + 16) ^ wy_secret[2], wy_read8(p + 24) ^ see1);
+                see2 = wy_mix(wy_read8(p + 32) ^ wy_secret[3], wy_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = wy_mix(wy_read8(p) ^ wy_secret[1], wy_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = wy_read8(p + i - 16);
+        b = wy_read8(p + i - 8);
+    }
+    a ^= wy_secret[1];
+    b ^= seed;
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0] ^ len, b ^ wy_secret[1]);
+}
+
+// The wyhash mixer for a single 64-bit value: two multiplies, every input bit reaches
+// every output bit, which std::hash<integer> (the identity in libstdc++) does not do
+inline uint64_t wyhash(uint64_t x, uint64_t seed = 0)
+{
+    using namespace internal;
+    uint64_t a = x ^ wy_secret[0], b = seed ^ wy_secret[1];
+    wy_mum(&a, &b);
+    return wy_mix(a ^ wy_secret[0], b ^ wy_secret[1]);
+}
+
+// Transparent hash and equality for string keys, so that containers keyed by zen::string
+// or std::string can be searched with a std::string_view or a const char* without first
+// building a temporary string from it. Strings are hashed with zen::wyhash, optionally
+// seeded per container; define ZEN_STRING_HASH_STD to fall back to std::hash.
+// Example: zen::hash_map<zen::string, int> m; m.find(std::string_view("key"));
+//          zen::hash_set<zen::string> s(0, zen::string_hash(seed));
+struct string_hash {
+    using is_transparent = void;
+
+    string_hash() = default;
+    explicit string_hash(uint64_t seed) : seed(seed) {}
+
+    size_t operator()(const std::string_view s) const
+    {
+#ifdef ZEN_STRING_HASH_STD
+        return std::hash<std::string_view>()(s);
+#else
+        return static_cast<size_t>(zen::wyhash(s.data(), s.size(), seed));
+#endif
+    }
+
+    uint64_t seed = 0;
+};
+
+// A drop-in hasher for integer, enum and pointer keys of the zen hash containers,
+// for when keys share their low bits (ids with a stride, aligned addresses...)
+// Example: zen::unordered_set<uint64_t, zen::fast_hash<uint64_t>> seen;
+template<class T>
+struct fast_hash {
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>,
+        "zen::fast_hash IS FOR INTEGERS, ENUMS AND POINTERS, USE zen::string_hash FOR STRINGS");
+
+    fast_hash() = default;
+    explicit fast_hash(uint64_t seed) : seed(seed) {}
+
+    size_t operator()(const T x) const
+    {
+        if constexpr (std::is_pointer_v<T>)
+            return static_cast<size_t>(zen::wyhash(reinterpret_cast<uintptr_t>(x), seed));
+        else
+            return static_cast<size_t>(zen::wyhash(static_cast<uint64_t>(x), seed));
+    }
+
+    uint64_t seed = 0;
+};
+
+struct string_equal {
+    using is_transparent = void;
+
+    bool operator()(const std::string_view a, const std::string_view b) const { return a == b; }
+};
+
+namespace internal {
+    template<class K>
+    constexpr bool is_string_key_v = std::is_same_v<K, std::string> || std::is_same_v<K, zen::string>;
+
+    // The hash, equality and ordering the zen containers use by default:
+    // transparent ones for string keys, the standard ones for everything else
+    template<class K> using default_hash  = std::conditional_t<is_string_key_v<K>, zen::string_hash,  std::hash<K>>;
+    template<class K> using default_equal = std::conditional_t<is_string_key_v<K>, zen::string_equal, std::equal_to<K>>;
+    template<class K> using default_less  = std::conditional_t<is_string_key_v<K>, std::less<>,       std::less<K>>;
+} // namespace internal
+
+///////////////////////////////////////////////////////////////////////////////////////////// BULK INGEST
+
+// Appends every element of src to dst in one go, whatever the two containers are:
+// - reserves room up front when dst has reserve() and src knows its size,
+// - moves the elements out of src when it's an rvalue (a temporary, or std::move(x)),
+// - passes the whole range to dst's range insert() when it has one,
+//   and only falls back to one push_back()/push() per element otherwise.
+// The iterable constructors of the zen containers are built on it.
+// Example: zen::vector<zen::string> names;
+//          zen::ingest(names, std::move(parsed_names)); // no string is copied
+template<class Container, class Iterable>
+Container& ingest(Container& dst, Iterable&& src)
+{
+    ZEN_STATIC_ASSERT(zen::is_iterable_v<std::remove_cvref_t<Iterable>>, "TEMPLATE PARAMETER EXPECTED TO BE Iterable, BUT IS NOT");
+
+    if constexpr (requires { dst.reserve(dst.size() + std::size(src)); })
+        dst.reserve(dst.size() + std::size(src));
+
+    const auto append = [&dst](auto first, auto last) {
+        if constexpr (requires { dst.insert(dst.end(), first, last); })
+            dst.insert(dst.end(), first, last);
+        else if constexpr (requires { dst.insert(first, last); })
+            dst.insert(first, last);
+        else if constexpr (requires { dst.push_back(*first); })
+            for (; first != last; ++first)
+                dst.push_back(*first);
+        else
+            for (; first != last; ++first)
+                dst.push(*first);
+    };
+
+    if constexpr (std::is_lvalue_reference_v<Iterable>)
+        append(std::begin(src), std::end(src));
+    else
+        append(std::make_move_iterator(std::begin(src)), std::make_move_iterator(std::end(src)));
+    return dst;
+}
+
+namespace internal {
+    // Whether a zen container's iterable constructor should take Iterable: it must be
+    // iterable, but not the container's own std base (that's the copy/move constructor's job)
+    template<class Iterable, class Base>
+    concept ingestible = zen::is_iterable_v<std::remove_cvref_t<Iterable>>
+                      && !std::is_base_of_v<Base, std::remove_cvref_t<Iterable>>;
+} // namespace internal
+
 ///////////////////////////////////////////////////////////////////////////////////////////// zen::deque
 
 template<class T, class A = std::allocator<T>>
@@ -713,6 +1629,10 @@ public:
 
     deque(const std::deque<T, A>& d) : std::deque<T, A>(d) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::deque<T, A>>
+    explicit deque(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     template<class Pred>
     typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
          contains(Pred p) const
@@ -841,362 +1761,2754 @@ std::filesystem::path operator ""_path(const char* str, std::size_t length)
 
 } // namespace literals::path
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::forward_list
-
-template<class T, class A = std::allocator<T>>
-class forward_list : public std::forward_list<T, A>, private zen::stackonly
-{
-public:
-    using std::forward_list<T, A>::forward_list; // inherit constructors, has to be explicit
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_hash_map
+
+namespace internal {
+    // Control bytes of an open-addressing table. A full slot's byte holds 7 bits of its
+    // key's hash (0..127); free slots hold one of these negative markers.
+    enum : int8_t {
+        ctrl_empty   = -128,
+        ctrl_deleted = -2,
+    };
+
+    inline constexpr size_t ctrl_group_width = 16;
+
+    // The 16 control bytes of a group, tested all at once. Each match returns a mask
+    // with bit i set for every byte i that qualifies.
+    class ctrl_group {
+    public:
+#if ZEN_HAS_SSE2
+        explicit ctrl_group(const int8_t* ctrl) : v_(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl))) {}
+
+        uint32_t match(int8_t h2) const { return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v_, _mm_set1_epi8(h2)))); }
+        uint32_t match_empty()    const { return match(ctrl_empty); }
+        uint32_t match_free()     const { return static_cast<uint32_t>(_mm_movemask_epi8(v_)); } // the sign bits
+
+    private:
+        __m128i v_;
+#else
+        explicit ctrl_group(const int8_t* ctrl) : ctrl_(ctrl) {}
+
+        uint32_t match(int8_t h2) const { return mask([h2](int8_t c) { return c == h2; }); }
+        uint32_t match_empty()    const { return match(ctrl_empty); }
+        uint32_t match_free()     const { return mask([](int8_t c) { return c < 0; }); }
+
+    private:
+        template<class Pred>
+        uint32_t mask(Pred pred) const
+        {
+            uint32_t m = 0;
+            for (size_t i = 0; i < ctrl_group_width; ++i)
+                m |= static_cast<uint32_t>(pred(ctrl_[i])) << i;
+            return m;
+        }
+
+        const int8_t* ctrl_;
+#endif
+    };
+
+    // Spreads the entropy of weak hashes (std::hash<int> is the identity) over all 64 bits
+    inline uint64_t mix_hash(uint64_t h)
+    {
+        h *= 0x9E3779B97F4A7C15ull;
+        return h ^ (h >> 32);
+    }
+} // namespace internal
+
+// An open-addressing hash map in the style of Abseil's SwissTable, with the surface of
+// zen::unordered_map. Elements live in one flat array of slots, next to an array of
+// one control byte per slot. A lookup tests 16 control bytes with a couple of SSE2
+// instructions, and compares keys only on a 7-bit hash match, so it usually touches
+// one cache line of control bytes and one slot. Unlike std::unordered_map, any insertion
+// may move the elements, which invalidates iterators, pointers and references to them.
+// Example: zen::flat_hash_map<zen::string, int> m = {{"one", 1}, {"two", 2}};
+template<
+    class K,
+    class V,
+    class H = internal::default_hash<K>,
+    class E = internal::default_equal<K>,
+    class A = std::allocator<std::pair<const K, V>>
+>
+class flat_hash_map : private zen::stackonly
+{
+public:
+    using key_type        = K;
+    using mapped_type     = V;
+    using value_type      = std::pair<const K, V>;
+    using size_type       = size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher          = H;
+    using key_equal       = E;
+    using allocator_type  = A;
+    using reference       = value_type&;
+    using const_reference = const value_type&;
+
+    template<bool Const>
+    class basic_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = flat_hash_map::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = std::conditional_t<Const, const value_type*, value_type*>;
+        using reference         = std::conditional_t<Const, const value_type&, value_type&>;
+
+        basic_iterator() = default;
+
+        // iterator converts to const_iterator
+        template<bool C = Const, class = std::enable_if_t<C>>
+        basic_iterator(const basic_iterator<false>& it) : ctrl_(it.ctrl_), end_(it.end_), slot_(it.slot_) {}
+
+        reference operator*()  const { return *slot_; }
+        pointer   operator->() const { return slot_; }
+
+        basic_iterator& operator++()
+        {
+            ++ctrl_;
+            ++slot_;
+            skip_free();
+            return *this;
+        }
+
+        basic_iterator operator++(int) { basic_iterator old = *this; ++*this; return old; }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.ctrl_ == b.ctrl_; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.ctrl_ != b.ctrl_; }
+
+    private:
+        friend class flat_hash_map;
+
+        basic_iterator(const int8_t* ctrl, const int8_t* end, pointer slot) : ctrl_(ctrl), end_(end), slot_(slot) {}
+
+        void skip_free()
+        {
+            while (ctrl_ != end_ && *ctrl_ < 0) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+        const int8_t* ctrl_ = nullptr;
+        const int8_t* end_  = nullptr;
+        pointer       slot_ = nullptr;
+    };
+
+    using iterator       = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+
+    // True when both H and E accept keys other than K (see zen::string_hash)
+    static constexpr bool transparent = requires { typename H::is_transparent; typename E::is_transparent; };
+
+    flat_hash_map() = default;
+
+    flat_hash_map(std::initializer_list<value_type> init) : flat_hash_map(init.begin(), init.end()) {}
+
+    template<class It>
+    flat_hash_map(It first, It last)
+    {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>)
+            reserve(static_cast<size_t>(std::distance(first, last)));
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    template<class Kx, class Vx, class Hx, class Ex, class Ax>
+    flat_hash_map(const std::unordered_map<Kx, Vx, Hx, Ex, Ax>& u) : flat_hash_map(u.begin(), u.end()) {}
+
+    flat_hash_map(const flat_hash_map& other) : hash_(other.hash_), equal_(other.equal_), alloc_(other.alloc_)
+    {
+        reserve(other.size());
+        for (const auto& x : other)
+            insert(x);
+    }
+
+    flat_hash_map(flat_hash_map&& other) noexcept
+        : hash_(std::move(other.hash_)), equal_(std::move(other.equal_)), alloc_(std::move(other.alloc_))
+    {
+        steal(other);
+    }
+
+    flat_hash_map& operator=(flat_hash_map other) noexcept
+    {
+        destroy();
+        hash_  = std::move(other.hash_);
+        equal_ = std::move(other.equal_);
+        alloc_ = std::move(other.alloc_);
+        steal(other);
+        return *this;
+    }
+
+    ~flat_hash_map() { destroy(); }
+
+    iterator       begin()        { return make_iterator<false>(0); }
+    const_iterator begin()  const { return make_iterator<true>(0); }
+    const_iterator cbegin() const { return begin(); }
+    iterator       end()          { return make_iterator<false>(capacity_); }
+    const_iterator end()    const { return make_iterator<true>(capacity_); }
+    const_iterator cend()   const { return end(); }
+
+    size_t size()         const { return size_; }
+    bool   empty()        const { return size_ == 0; }
+    bool   is_empty()     const { return empty(); }
+    size_t bucket_count() const { return capacity_; }
+    float  load_factor()  const { return capacity_ ? static_cast<float>(size_) / static_cast<float>(capacity_) : 0.0f; }
+
+    // Makes room for n elements without any further rehashing
+    void reserve(size_t n)
+    {
+        if (n == 0)
+            return;
+        size_t capacity = internal::ctrl_group_width;
+        while (max_load(capacity) < n)
+            capacity *= 2;
+        if (capacity > capacity_)
+            rehash(capacity);
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < capacity_; ++i)
+            if (ctrl_[i] >= 0)
+                std::allocator_traits<A>::destroy(alloc_, slots_ + i);
+        std::fill_n(ctrl_, capacity_, static_cast<int8_t>(internal::ctrl_empty));
+        size_        = 0;
+        growth_left_ = max_load(capacity_);
+    }
+
+    std::pair<iterator, bool> insert(const value_type& x) { return try_emplace(x.first, x.second); }
+    std::pair<iterator, bool> insert(value_type&& x)      { return try_emplace(x.first, std::move(x.second)); }
+
+    template<class P, class = std::enable_if_t<std::is_constructible_v<value_type, P&&>>>
+    std::pair<iterator, bool> insert(P&& x) { return emplace(std::forward<P>(x)); }
+
+    // The hint is ignored; it only makes the map usable with std::inserter() and the like
+    iterator insert(const_iterator, const value_type& x) { return insert(x).first; }
+    iterator insert(const_iterator, value_type&& x)      { return insert(std::move(x)).first; }
+
+    template<class It>
+    void insert(It first, It last)
+    {
+        for (; first != last; ++first)
+            insert(*first);
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type x(std::forward<Args>(args)...);
+        return try_emplace(x.first, std::move(x.second)); // the key is const, so it is copied
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) { return emplace_key(key, std::forward<Args>(args)...); }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) { return emplace_key(std::move(key), std::forward<Args>(args)...); }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key)      { return try_emplace(std::move(key)).first->second; }
+
+    V& at(const K& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        if (i == npos)
+            throw std::out_of_range("FLAT_HASH_MAP KEY NOT FOUND");
+        return slots_[i].second;
+    }
+
+    const V& at(const K& key) const { return const_cast<flat_hash_map*>(this)->at(key); }
+
+    iterator find(const K& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : make_iterator<false>(i);
+    }
+
+    const_iterator find(const K& key) const
+    {
+        const size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : make_iterator<true>(i);
+    }
+
+    bool   contains(const K& key) const { return find_index(key, hash_of(key)) != npos; }
+    size_t count   (const K& key) const { return contains(key); }
+
+    // With a transparent hasher and key_equal (the default for string keys, see
+    // zen::string_hash), lookups take anything they accept, e.g. a std::string_view
+    template<class Q> requires transparent
+    iterator find(const Q& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : make_iterator<false>(i);
+    }
+
+    template<class Q> requires transparent
+    const_iterator find(const Q& key) const
+    {
+        const size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : make_iterator<true>(i);
+    }
+
+    template<class Q> requires transparent
+    bool contains(const Q& key) const { return find_index(key, hash_of(key)) != npos; }
+
+    template<class Q> requires transparent
+    size_t count(const Q& key) const { return contains(key); }
+
+    template<class Q> requires transparent
+    V& at(const Q& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        if (i == npos)
+            throw std::out_of_range("FLAT_HASH_MAP KEY NOT FOUND");
+        return slots_[i].second;
+    }
+
+    template<class Q> requires transparent && (!std::is_convertible_v<const Q&, const_iterator>)
+    size_t erase(const Q& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        if (i == npos)
+            return 0;
+        erase_at(i);
+        return 1;
+    }
+
+    size_t erase(const K& key)
+    {
+        const size_t i = find_index(key, hash_of(key));
+        if (i == npos)
+            return 0;
+        erase_at(i);
+        return 1;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        const size_t i = static_cast<size_t>(pos.ctrl_ - ctrl_);
+        erase_at(i);
+        iterator next = make_iterator<false>(i);
+        next.skip_free();
+        return next;
+    }
+
+    iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+    void swap(flat_hash_map& other) noexcept
+    {
+        std::swap(hash_,        other.hash_);
+        std::swap(equal_,       other.equal_);
+        std::swap(alloc_,       other.alloc_);
+        std::swap(ctrl_,        other.ctrl_);
+        std::swap(slots_,       other.slots_);
+        std::swap(capacity_,    other.capacity_);
+        std::swap(size_,        other.size_);
+        std::swap(growth_left_, other.growth_left_);
+    }
+
+    friend bool operator==(const flat_hash_map& a, const flat_hash_map& b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (const auto& [key, value] : a) {
+            const auto it = b.find(key);
+            if (it == b.end() || !(it->second == value))
+                return false;
+        }
+        return true;
+    }
+    friend bool operator!=(const flat_hash_map& a, const flat_hash_map& b) { return !(a == b); }
+
+private:
+    using ctrl_allocator = typename std::allocator_traits<A>::template rebind_alloc<int8_t>;
+
+    static constexpr size_t npos = size_t(-1);
+
+    // At most 7/8 of the slots are used, so every probe sequence meets an empty slot
+    static size_t max_load(size_t capacity) { return capacity - capacity / 8; }
+
+    static int8_t h2(uint64_t h) { return static_cast<int8_t>(h & 0x7F); }
+
+    template<class Kx, class... Args>
+    std::pair<iterator, bool> emplace_key(Kx&& key, Args&&... args)
+    {
+        const uint64_t h = hash_of(key);
+        if (const size_t i = find_index(key, h); i != npos)
+            return { make_iterator<false>(i), false };
+
+        if (growth_left_ == 0) {
+            // Grow if the table is really getting full, otherwise just clear out the tombstones
+            rehash(size_ + 1 > max_load(capacity_) / 2 ? std::max(capacity_ * 2, internal::ctrl_group_width) : capacity_);
+        }
+
+        const size_t i = find_free(h);
+        std::allocator_traits<A>::construct(alloc_, slots_ + i, std::piecewise_construct,
+                                            std::forward_as_tuple(std::forward<Kx>(key)),
+                                            std::forward_as_tuple(std::forward<Args>(args)...));
+        growth_left_ -= ctrl_[i] == internal::ctrl_empty;
+        ctrl_[i] = h2(h);
+        ++size_;
+        return { make_iterator<false>(i), true };
+    }
+
+    template<class Q>
+    uint64_t hash_of(const Q& key) const { return internal::mix_hash(static_cast<uint64_t>(hash_(key))); }
+
+    template<bool Const>
+    basic_iterator<Const> make_iterator(size_t i) const
+    {
+        basic_iterator<Const> it(ctrl_ + i, ctrl_ + capacity_, slots_ + i);
+        it.skip_free();
+        return it;
+    }
+
+    // Groups are visited in triangular-number steps, which covers all of them when
+    // their number is a power of two
+    template<class Q>
+    size_t find_index(const Q& key, uint64_t h) const
+    {
+        if (capacity_ == 0)
+            return npos;
+
+        const size_t mask = capacity_ / internal::ctrl_group_width - 1;
+        size_t group = static_cast<size_t>(h >> 7) & mask;
+        for (size_t step = 1; ; ++step) {
+            const size_t first = group * internal::ctrl_group_width;
+            const internal::ctrl_group g(ctrl_ + first);
+            for (uint32_t m = g.match(h2(h)); m != 0; m &= m - 1) {
+                const size_t i = first + static_cast<size_t>(std::countr_zero(m));
+                if (equal_(slots_[i].first, key))
+                    return i;
+            }
+            if (g.match_empty())
+                return npos;
+            group = (group + step) & mask;
+        }
+    }
+
+    size_t find_free(uint64_t h) const
+    {
+        const size_t mask = capacity_ / internal::ctrl_group_width - 1;
+        size_t group = static_cast<size_t>(h >> 7) & mask;
+        for (size_t step = 1; ; ++step) {
+            const size_t first = group * internal::ctrl_group_width;
+            if (const uint32_t m = internal::ctrl_group(ctrl_ + first).match_free())
+                return first + static_cast<size_t>(std::countr_zero(m));
+            group = (group + step) & mask;
+        }
+    }
+
+    void erase_at(size_t i)
+    {
+        std::allocator_traits<A>::destroy(alloc_, slots_ + i);
+        --size_;
+
+        // A lookup stops at the first group with an empty slot, so if this group has one,
+        // no probe sequence continues past it and the slot can simply become empty again
+        const size_t first = i - i % internal::ctrl_group_width;
+        if (internal::ctrl_group(ctrl_ + first).match_empty()) {
+            ctrl_[i] = internal::ctrl_empty;
+            ++growth_left_;
+        } else {
+            ctrl_[i] = internal::ctrl_deleted;
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        int8_t*     old_ctrl     = ctrl_;
+        value_type* old_slots    = slots_;
+        const size_t old_capacity = capacity_;
+
+        ctrl_allocator ctrl_alloc(alloc_);
+        ctrl_  = std::allocator_traits<ctrl_allocator>::allocate(ctrl_alloc, capacity);
+        slots_ = std::allocator_traits<A>::allocate(alloc_, capacity);
+        capacity_    = capacity;
+        growth_left_ = max_load(capacity) - size_;
+        std::fill_n(ctrl_, capacity, static_cast<int8_t>(internal::ctrl_empty));
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] < 0)
+                continue;
+            value_type& x = old_slots[i];
+            const uint64_t h = hash_of(x.first);
+            const size_t j = find_free(h);
+            // The key is const and cannot be moved from, so it is copied; only the value moves
+            std::allocator_traits<A>::construct(alloc_, slots_ + j, x.first, std::move(x.second));
+            std::allocator_traits<A>::destroy(alloc_, &x);
+            ctrl_[j] = h2(h);
+        }
+
+        if (old_capacity != 0) {
+            std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, old_ctrl, old_capacity);
+            std::allocator_traits<A>::deallocate(alloc_, old_slots, old_capacity);
+        }
+    }
+
+    void destroy()
+    {
+        if (capacity_ == 0)
+            return;
+        clear();
+        ctrl_allocator ctrl_alloc(alloc_);
+        std::allocator_traits<ctrl_allocator>::deallocate(ctrl_alloc, ctrl_, capacity_);
+        std::allocator_traits<A>::deallocate(alloc_, slots_, capacity_);
+        ctrl_        = nullptr;
+        slots_       = nullptr;
+        capacity_    = 0;
+        growth_left_ = 0;
+    }
+
+    void steal(flat_hash_map& other)
+    {
+        ctrl_        = std::exchange(other.ctrl_,        nullptr);
+        slots_       = std::exchange(other.slots_,       nullptr);
+        capacity_    = std::exchange(other.capacity_,    0);
+        size_        = std::exchange(other.size_,        0);
+        growth_left_ = std::exchange(other.growth_left_, 0);
+    }
+
+    H           hash_;
+    E           equal_;
+    A           alloc_;
+    int8_t*     ctrl_        = nullptr;
+    value_type* slots_       = nullptr;
+    size_t      capacity_    = 0; // a power of two, and a multiple of the group width
+    size_t      size_        = 0;
+    size_t      growth_left_ = 0; // empty slots that can still be filled before a rehash
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_map
+
+namespace internal {
+    // Binary search with no data-dependent branch: every step is one comparison feeding
+    // a conditional move, so it always takes ceil(log2(n)) steps but never mispredicts.
+    // Returns the first element whose key(x) is not less than value, like std::lower_bound.
+    template<class T, class Q, class Less, class KeyOf>
+    const T* branchless_lower_bound(const T* first, size_t n, const Q& value, const Less& less, KeyOf key)
+    {
+        if (n == 0)
+            return first;
+        while (n > 1) {
+            const size_t half = n / 2;
+            first = less(key(first[half]), value) ? first + half : first;
+            n -= half;
+        }
+        return first + less(key(*first), value);
+    }
+
+    // Sorts the elements appended at [from, end) and merges them into the sorted prefix.
+    // Both sorts are stable and std::unique keeps the first of equal elements, so an
+    // element already present wins over a new one, and an earlier new one over a later one.
+    template<class Vector, class Less>
+    void merge_sorted_tail(Vector& v, size_t from, const Less& less)
+    {
+        const auto mid = v.begin() + static_cast<std::ptrdiff_t>(from);
+        if (!std::is_sorted(mid, v.end(), less))
+            std::stable_sort(mid, v.end(), less);
+        std::inplace_merge(v.begin(), mid, v.end(), less);
+        v.erase(std::unique(v.begin(), v.end(), [&less](const auto& a, const auto& b) { return !less(a, b); }), v.end());
+    }
+} // namespace internal
+
+// A map over one sorted std::vector of key/value pairs: lookups are a binary search over
+// contiguous memory instead of a walk through one heap node per level, and the whole map
+// is a single allocation. Inserting or erasing one element moves the ones after it, so it
+// suits tables that are built once (from a range, at once) and then mostly read.
+// Unlike zen::map, value_type is std::pair<K, V>: do not change a key through an iterator,
+// and inserting or erasing invalidates iterators and references.
+// Example: zen::flat_map<zen::string, int> ports = { {"http", 80}, {"https", 443} };
+//          if (ports.contains("http")) ...
+template<
+    class K,
+    class V,
+    class C = internal::default_less<K>,
+    class A = std::allocator<std::pair<K, V>>
+>
+class flat_map : private zen::stackonly
+{
+public:
+    using key_type        = K;
+    using mapped_type     = V;
+    using value_type      = std::pair<K, V>;
+    using key_compare     = C;
+    using allocator_type  = A;
+    using container_type  = std::vector<value_type, A>;
+    using size_type       = size_t;
+    using iterator        = typename container_type::iterator;
+    using const_iterator  = typename container_type::const_iterator;
+
+    // True when C compares keys with other types (e.g. std::less<> for string keys)
+    static constexpr bool transparent = requires { typename C::is_transparent; };
+
+    flat_map() = default;
+
+    // Takes the pairs in any order and sorts them once; of equal keys the first one is kept
+    explicit flat_map(container_type pairs, const C& comp = C()) : items_(std::move(pairs)), comp_(comp)
+    {
+        internal::merge_sorted_tail(items_, 0, value_less());
+    }
+
+    template<class It>
+    flat_map(It first, It last, const C& comp = C()) : flat_map(container_type(first, last), comp) {}
+
+    flat_map(std::initializer_list<value_type> init, const C& comp = C()) : flat_map(init.begin(), init.end(), comp) {}
+
+    template<class Kx, class Vx, class Cx, class Ax>
+    flat_map(const std::map<Kx, Vx, Cx, Ax>& m) : flat_map(m.begin(), m.end()) {}
+
+    iterator       begin()        { return items_.begin(); }
+    const_iterator begin()  const { return items_.begin(); }
+    const_iterator cbegin() const { return items_.cbegin(); }
+    iterator       end()          { return items_.end(); }
+    const_iterator end()    const { return items_.end(); }
+    const_iterator cend()   const { return items_.cend(); }
+
+    size_t size()     const { return items_.size(); }
+    bool   empty()    const { return items_.empty(); }
+    bool   is_empty() const { return empty(); }
+    size_t capacity() const { return items_.capacity(); }
+
+    void reserve(size_t n) { items_.reserve(n); }
+    void shrink_to_fit()   { items_.shrink_to_fit(); }
+    void clear()           { items_.clear(); }
+
+    // The sorted pairs themselves, e.g. to serialize them or to hand them to a std algorithm
+    const container_type& items() const { return items_; }
+
+    std::pair<iterator, bool> insert(const value_type& x) { return try_emplace(x.first, x.second); }
+    std::pair<iterator, bool> insert(value_type&& x)      { return try_emplace(std::move(x.first), std::move(x.second)); }
+
+    // Appends the whole range, then sorts and merges once: O((n + m) log m) rather than
+    // the O(n * m) of inserting the m new elements one by one
+    template<class It>
+    void insert(It first, It last)
+    {
+        const size_t old_size = items_.size();
+        items_.insert(items_.end(), first, last);
+        internal::merge_sorted_tail(items_, old_size, value_less());
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type x(std::forward<Args>(args)...);
+        return try_emplace(std::move(x.first), std::move(x.second));
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) { return emplace_key(key, std::forward<Args>(args)...); }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) { return emplace_key(std::move(key), std::forward<Args>(args)...); }
+
+    V& operator[](const K& key) { return try_emplace(key).first->second; }
+    V& operator[](K&& key)      { return try_emplace(std::move(key)).first->second; }
+
+    V&       at(const K& key)       { return checked_at(key); }
+    const V& at(const K& key) const { return const_cast<flat_map*>(this)->checked_at(key); }
+
+    iterator       find(const K& key)           { return begin() + find_index(key); }
+    const_iterator find(const K& key)     const { return begin() + find_index(key); }
+    bool           contains(const K& key) const { return find_index(key) != size(); }
+    size_t         count(const K& key)    const { return contains(key); }
+
+    iterator       lower_bound(const K& key)       { return begin() + lower_index(key); }
+    const_iterator lower_bound(const K& key) const { return begin() + lower_index(key); }
+    iterator       upper_bound(const K& key)       { return begin() + upper_index(key); }
+    const_iterator upper_bound(const K& key) const { return begin() + upper_index(key); }
+
+    // With a transparent comparator (the default for string keys), lookups take
+    // anything it accepts, e.g. a std::string_view or a const char*
+    template<class Q> requires transparent V&             at(const Q& key)                { return checked_at(key); }
+    template<class Q> requires transparent const V&       at(const Q& key)          const { return const_cast<flat_map*>(this)->checked_at(key); }
+    template<class Q> requires transparent iterator       find(const Q& key)              { return begin() + find_index(key); }
+    template<class Q> requires transparent const_iterator find(const Q& key)        const { return begin() + find_index(key); }
+    template<class Q> requires transparent bool           contains(const Q& key)    const { return find_index(key) != size(); }
+    template<class Q> requires transparent size_t         count(const Q& key)       const { return contains(key); }
+    template<class Q> requires transparent iterator       lower_bound(const Q& key)       { return begin() + lower_index(key); }
+    template<class Q> requires transparent const_iterator lower_bound(const Q& key) const { return begin() + lower_index(key); }
+    template<class Q> requires transparent iterator       upper_bound(const Q& key)       { return begin() + upper_index(key); }
+    template<class Q> requires transparent const_iterator upper_bound(const Q& key) const { return begin() + upper_index(key); }
+
+    iterator erase(const_iterator pos)                        { return items_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return items_.erase(first, last); }
+
+    size_t erase(const K& key) { return erase_key(key); }
+
+    template<class Q> requires transparent && (!std::is_convertible_v<const Q&, const_iterator>)
+    size_t erase(const Q& key) { return erase_key(key); }
+
+    void swap(flat_map& other) noexcept
+    {
+        std::swap(items_, other.items_);
+        std::swap(comp_,  other.comp_);
+    }
+
+    friend bool operator==(const flat_map& a, const flat_map& b) { return a.items_ == b.items_; }
+    friend bool operator!=(const flat_map& a, const flat_map& b) { return !(a == b); }
+
+private:
+    auto value_less() const { return [this](const value_type& a, const value_type& b) { return comp_(a.first, b.first); }; }
+
+    template<class Q>
+    size_t lower_index(const Q& key) const
+    {
+        const auto key_of = [](const value_type& x) -> const K& { return x.first; };
+        return static_cast<size_t>(internal::branchless_lower_bound(items_.data(), items_.size(), key, comp_, key_of) - items_.data());
+    }
+
+    template<class Q>
+    size_t upper_index(const Q& key) const
+    {
+        const size_t i = lower_index(key);
+        return i != size() && !comp_(key, items_[i].first) ? i + 1 : i;
+    }
+
+    // size() when the key is absent
+    template<class Q>
+    size_t find_index(const Q& key) const
+    {
+        const size_t i = lower_index(key);
+        return i != size() && !comp_(key, items_[i].first) ? i : size();
+    }
+
+    template<class Q>
+    V& checked_at(const Q& key)
+    {
+        const size_t i = find_index(key);
+        if (i == size())
+            throw std::out_of_range("FLAT_MAP KEY NOT FOUND");
+        return items_[i].second;
+    }
+
+    template<class Q>
+    size_t erase_key(const Q& key)
+    {
+        const size_t i = find_index(key);
+        if (i == size())
+            return 0;
+        items_.erase(items_.begin() + static_cast<std::ptrdiff_t>(i));
+        return 1;
+    }
+
+    template<class Key, class... Args>
+    std::pair<iterator, bool> emplace_key(Key&& key, Args&&... args)
+    {
+        const size_t i   = lower_index(key);
+        const auto   pos = begin() + static_cast<std::ptrdiff_t>(i);
+        if (i != size() && !comp_(key, pos->first))
+            return { pos, false };
+        return { items_.emplace(pos, std::piecewise_construct,
+            std::forward_as_tuple(std::forward<Key>(key)), std::forward_as_tuple(std::forward<Args>(args)...)), true };
+    }
+
+    container_type items_;
+    C              comp_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::flat_set
+
+// The set counterpart of zen::flat_map: the keys in one sorted std::vector,
+// searched without branches, meant to be built in bulk and then mostly read.
+// Iterators are const and get invalidated by inserting or erasing.
+// Example: zen::flat_set<int> primes = { 2, 3, 5, 7, 11 };
+//          bool b = primes.contains(5); // true
+template<class K, class C = internal::default_less<K>, class A = std::allocator<K>>
+class flat_set : private zen::stackonly
+{
+public:
+    using key_type        = K;
+    using value_type      = K;
+    using key_compare     = C;
+    using allocator_type  = A;
+    using container_type  = std::vector<K, A>;
+    using size_type       = size_t;
+    using iterator        = typename container_type::const_iterator;
+    using const_iterator  = typename container_type::const_iterator;
+
+    // True when C compares keys with other types (e.g. std::less<> for string keys)
+    static constexpr bool transparent = requires { typename C::is_transparent; };
+
+    flat_set() = default;
+
+    // Takes the keys in any order, sorts them once and drops the duplicates
+    explicit flat_set(container_type keys, const C& comp = C()) : keys_(std::move(keys)), comp_(comp)
+    {
+        internal::merge_sorted_tail(keys_, 0, comp_);
+    }
+
+    template<class It>
+    flat_set(It first, It last, const C& comp = C()) : flat_set(container_type(first, last), comp) {}
+
+    flat_set(std::initializer_list<K> init, const C& comp = C()) : flat_set(init.begin(), init.end(), comp) {}
+
+    template<class Kx, class Cx, class Ax>
+    flat_set(const std::set<Kx, Cx, Ax>& s) : flat_set(s.begin(), s.end()) {}
+
+    const_iterator begin()  const { return keys_.begin(); }
+    const_iterator cbegin() const { return keys_.cbegin(); }
+    const_iterator end()    const { return keys_.end(); }
+    const_iterator cend()   const { return keys_.cend(); }
+
+    size_t size()     const { return keys_.size(); }
+    bool   empty()    const { return keys_.empty(); }
+    bool   is_empty() const { return empty(); }
+    size_t capacity() const { return keys_.capacity(); }
+
+    void reserve(size_t n) { keys_.reserve(n); }
+    void shrink_to_fit()   { keys_.shrink_to_fit(); }
+    void clear()           { keys_.clear(); }
+
+    // The sorted keys themselves
+    const container_type& keys() const { return keys_; }
+
+    std::pair<iterator, bool> insert(const K& key) { return insert_key(key); }
+    std::pair<iterator, bool> insert(K&& key)      { return insert_key(std::move(key)); }
+
+    // Appends the whole range, then sorts and merges once (see zen::flat_map::insert)
+    template<class It>
+    void insert(It first, It last)
+    {
+        const size_t old_size = keys_.size();
+        keys_.insert(keys_.end(), first, last);
+        internal::merge_sorted_tail(keys_, old_size, comp_);
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) { return insert_key(K(std::forward<Args>(args)...)); }
+
+    const_iterator find(const K& key)        const { return begin() + find_index(key); }
+    bool           contains(const K& key)    const { return find_index(key) != size(); }
+    size_t         count(const K& key)       const { return contains(key); }
+    const_iterator lower_bound(const K& key) const { return begin() + lower_index(key); }
+    const_iterator upper_bound(const K& key) const { return begin() + upper_index(key); }
+
+    template<class Q> requires transparent const_iterator find(const Q& key)        const { return begin() + find_index(key); }
+    template<class Q> requires transparent bool           contains(const Q& key)    const { return find_index(key) != size(); }
+    template<class Q> requires transparent size_t         count(const Q& key)       const { return contains(key); }
+    template<class Q> requires transparent const_iterator lower_bound(const Q& key) const { return begin() + lower_index(key); }
+    template<class Q> requires transparent const_iterator upper_bound(const Q& key) const { return begin() + upper_index(key); }
+
+    iterator erase(const_iterator pos)                        { return keys_.erase(pos); }
+    iterator erase(const_iterator first, const_iterator last) { return keys_.erase(first, last); }
+
+    size_t erase(const K& key) { return erase_key(key); }
+
+    template<class Q> requires transparent && (!std::is_convertible_v<const Q&, const_iterator>)
+    size_t erase(const Q& key) { return erase_key(key); }
+
+    void swap(flat_set& other) noexcept
+    {
+        std::swap(keys_, other.keys_);
+        std::swap(comp_, other.comp_);
+    }
+
+    friend bool operator==(const flat_set& a, const flat_set& b) { return a.keys_ == b.keys_; }
+    friend bool operator!=(const flat_set& a, const flat_set& b) { return !(a == b); }
+
+private:
+    template<class Q>
+    size_t lower_index(const Q& key) const
+    {
+        const auto key_of = [](const K& x) -> const K& { return x; };
+        return static_cast<size_t>(internal::branchless_lower_bound(keys_.data(), keys_.size(), key, comp_, key_of) - keys_.data());
+    }
+
+    template<class Q>
+    size_t upper_index(const Q& key) const
+    {
+        const size_t i = lower_index(key);
+        return i != size() && !comp_(key, keys_[i]) ? i + 1 : i;
+    }
+
+    // size() when the key is absent
+    template<class Q>
+    size_t find_index(const Q& key) const
+    {
+        const size_t i = lower_index(key);
+        return i != size() && !comp_(key, keys_[i]) ? i : size();
+    }
+
+    template<class Q>
+    size_t erase_key(const Q& key)
+    {
+        const size_t i = find_index(key);
+        if (i == size())
+            return 0;
+        keys_.erase(keys_.begin() + static_cast<std::ptrdiff_t>(i));
+        return 1;
+    }
+
+    template<class Key>
+    std::pair<iterator, bool> insert_key(Key&& key)
+    {
+        const size_t i   = lower_index(key);
+        const auto   pos = begin() + static_cast<std::ptrdiff_t>(i);
+        if (i != size() && !comp_(key, *pos))
+            return { pos, false };
+        return { keys_.insert(pos, std::forward<Key>(key)), true };
+    }
+
+    container_type keys_;
+    C              comp_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::forward_list
+
+template<class T, class A = std::allocator<T>>
+class forward_list : public std::forward_list<T, A>, private zen::stackonly
+{
+public:
+    using std::forward_list<T, A>::forward_list; // inherit constructors, has to be explicit
 
     forward_list(const std::forward_list<T, A>& x) : std::forward_list<T, A>(x) {}
 
-    template<class Pred>
-    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
-        contains(Pred p) const
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(my::begin(), my::end(), p) != my::end();
+    }
+    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = forward_list<T, A>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::in
+
+// Declarative range-for loop. Note that apart from an intuitive
+// reading, "in" can also be thought of standing for "interval".
+// Example: for (int i : zen::in(5))         // from  0 to  5
+// Example: for (int i : zen::in(1, 10))     // from  1 to 10
+// Example: for (int i : zen::in(10, 1, -1)) // from 10 to  1, step -1
+class in {
+public:
+    in(int end)
+        : begin_(0), end_(end), step_(1) {}
+
+    in(int begin, int end, int step = 1)
+        : begin_(begin), end_(end), step_(step) {}
+
+    class iterator {
+    public:
+        iterator(int n = 0, int step = 1) : n_(n), step_(step) {}
+        iterator& operator++() { n_ += step_; return *this; }
+        const int& operator*()             const { return n_; }
+        bool operator!=(const iterator& x) const {
+            return (step_ > 0) ? (n_ < x.n_) : (n_ > x.n_);
+        }
+    private:
+        int n_;
+        int step_;
+    };
+
+    iterator begin() const { return iterator(begin_, step_); }
+    iterator end()   const { return iterator(end_,   step_); }
+
+private:
+    int begin_;
+    int end_;
+    int step_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::list
+
+template<class T, class A = std::allocator<T>>
+class list : public std::list<T, A>, private zen::stackonly
+{
+public:
+    using std::list<T, A>::list; // inherit constructors, has to be explicit
+
+    list(const std::list<T, A>& x) : std::list<T, A>(x) {}
+
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(my::begin(), my::end(), p) != my::end();
+    }
+    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = list<T, A>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::map
+
+template<class K, class V, class C = internal::default_less<K>, class A = std::allocator<std::pair<const K, V>>>
+class map : public std::map<K, V, C, A>, private zen::stackonly
+{
+public:
+    using std::map<K, V, C, A>::map; // inherit constructors, has to be explicit
+
+    map(const std::map<K, V, C, A>& m) : std::map<K, V, C, A>(m) {}
+
+    template<class Kx, class Vx, class Cx, class Ax>
+    map(const std::map<Kx, Vx, Cx, Ax>& m) : std::map<K, V, C, A>(m.begin(), m.end()) {}
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = map<K, V, C, A>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::multimap
+
+template<class K, class V, class C = internal::default_less<K>, class A = std::allocator<std::pair<const K, V>>>
+class multimap : public std::multimap<K, V, C, A>, private zen::stackonly
+{
+public:
+    using std::multimap<K, V, C, A>::multimap; // inherit constructors, has to be explicit
+
+    multimap(const std::multimap<K, V, C, A>& m) : std::multimap<K, V, C, A>(m) {}
+
+    template<class Kx, class Vx, class Cx, class Ax>
+    multimap(const std::multimap<Kx, Vx, Cx, Ax>& m) : std::multimap<K, V, C, A>(m.begin(), m.end()) {}
+
+    // std::map::operator[] is not defined, but
+    // zen::map::operator[] returns an std::vector
+    // composed of values corresponding to the parameter key.
+    std::vector<V> operator[](const K& key) {
+        auto range = my::equal_range(key);
+        std::vector<V> values;
+        for (auto it = range.first; it != range.second; ++it) {
+            values.push_back(it->second);
+        }
+        return values;
+    }
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = multimap<K, V, C, A>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::point2d
+
+class point2d : public std::pair<double, double> {
+public:
+    point2d(double xc = 0.0, double yc = 0.0)    : std::pair<double, double>(xc, yc)       {}
+    point2d(const std::pair<double, double>&  p) : std::pair<double, double>(p)            {}
+    point2d(      std::pair<double, double>&& p) : std::pair<double, double>(std::move(p)) {}
+
+    // Allows conversions from other arithmetic pair types
+    template <class T, class U, typename std::enable_if<
+                                         std::is_arithmetic_v<T> &&
+                                         std::is_arithmetic_v<U>, int>::type = 0>
+    point2d(const std::pair<T, U>& p)
+        : std::pair<double, double>(
+            static_cast<double>(p.first),
+            static_cast<double>(p.second)
+        )
+    {}
+
+    point2d& operator=(const std::pair<double, double>& p) {
+        this->first  = p.first;
+        this->second = p.second;
+        return *this;
+    }
+
+    point2d& operator=(std::pair<double, double>&& p) {
+        this->first  = std::move(p.first);
+        this->second = std::move(p.second);
+        return *this;
+    }
+
+    // Returning reference to the member is deliberate since
+    // x() and y() are simply meant to be a convenience alias
+    // interface to avoid writing '.first' or '.second' 
+    constexpr double& x()       { return this->first;  }
+    constexpr double& y()       { return this->second; }
+    constexpr double  x() const { return this->first;  }
+    constexpr double  y() const { return this->second; }
+
+    friend point2d operator+(const point2d& a, const point2d& b) { return point2d(a.x() + b.x(), a.y() + b.y()); }
+    friend point2d operator-(const point2d& a, const point2d& b) { return point2d(a.x() - b.x(), a.y() - b.y()); }
+    friend point2d operator*(const point2d& a, const double   k) { return point2d(a.x() * k, a.y() * k); }
+    friend bool   operator==(const point2d& a, const point2d& b) { return a.x() == b.x() && a.y() == b.y(); }
+    friend bool   operator!=(const point2d& a, const point2d& b) { return !(a == b); }
+    friend point2d operator/(const point2d& a, double k) {
+        if (k != 0) {
+            return point2d(a.x() / k, a.y() / k);
+        } else {
+            throw std::invalid_argument("ATTEMPTED DIVISION BY ZERO FOR point2d");
+        }
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::point3d
+
+class point3d : public point2d {
+public:
+    point3d(double xc = 0.0, double yc = 0.0, double zc = 0.0) : point2d(xc, yc), z_(zc) {}
+
+    point3d(const point2d& p, double zc = 0.0) : point2d(p), z_(zc) {}
+
+    template <class T, class U, class V, typename std::enable_if<
+                                                  std::is_arithmetic_v<T> &&
+                                                  std::is_arithmetic_v<U> &&
+                                                  std::is_arithmetic_v<V>, int>::type = 0>
+    point3d(const std::tuple<T, U, V>& p)
+        : point2d(std::get<0>(p), std::get<1>(p)),
+           z_(static_cast<double>(std::get<2>(p)))
+    {}
+
+    point3d& operator=(const std::pair<double, double>& p) {
+        point2d::operator=(p);            // inherit behavior for x and y
+        z_ = 0;                           // reset to default
+        return *this;
+    }
+
+    point3d& operator=(std::pair<double, double>&& p) {
+        point2d::operator=(std::move(p)); // inherit behavior for x and y
+        z_ = 0;                           // reset to default
+        return *this;
+    }
+
+    // Returning reference to the member is deliberate since
+    // x(), y() and z() are simply meant to be a convenience alias
+    // interface to avoid writing '->first', '->second' or '->z_'
+    constexpr double& z()       { return z_; }
+    constexpr double  z() const { return z_; }
+
+    friend point3d operator+(const point3d& a, const point3d& b) { return point3d(a.x() + b.x(), a.y() + b.y(), a.z() + b.z()); }
+    friend point3d operator-(const point3d& a, const point3d& b) { return point3d(a.x() - b.x(), a.y() - b.y(), a.z() - b.z()); }
+    friend point3d operator*(const point3d& a, const double k)   { return point3d(a.x() * k, a.y() * k, a.z() * k); }
+    friend bool   operator==(const point3d& a, const point3d& b) { return a.x() == b.x() && a.y() == b.y() && a.z() == b.z(); }
+    friend bool   operator!=(const point3d& a, const point3d& b) { return !(a == b); }
+
+    friend point3d operator/(const point3d& a, double k) {
+        if (k != 0) {
+            return point3d(a.x() / k, a.y() / k, a.z() / k);
+        }
+        else {
+            throw std::invalid_argument("ATTEMPTED DIVISION BY ZERO FOR point3d");
+        }
+    }
+
+private:
+    double z_;
+};
+
+// ------------------------------------------------------------------------------------------ aliases
+
+using point = point2d;
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::point_cloud
+
+template<class T, class A> class vector; // forward declaration
+
+namespace internal {
+    // A std::allocator that aligns every block to Align bytes (e.g. a cache line)
+    template<class T, size_t Align>
+    struct aligned_allocator {
+        using value_type = T;
+
+        template<class U> struct rebind { using other = aligned_allocator<U, Align>; };
+
+        aligned_allocator() = default;
+        template<class U> aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+        T*   allocate(size_t n)            { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align))); }
+        void deallocate(T* p, size_t)      { ::operator delete(p, std::align_val_t(Align)); }
+
+        friend bool operator==(const aligned_allocator&, const aligned_allocator&) { return true; }
+    };
+
+    // p[i] += c and p[i] *= c over n doubles, four at a time with SSE2. Written out rather
+    // than left to the auto-vectorizer, which GCC only runs from -O3 (or at -O2 on loops
+    // it can prove need no scalar remainder).
+    inline void add_doubles(double* p, size_t n, double c)
+    {
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        const __m128d vc = _mm_set1_pd(c);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_pd(p + i,     _mm_add_pd(_mm_loadu_pd(p + i),     vc));
+            _mm_storeu_pd(p + i + 2, _mm_add_pd(_mm_loadu_pd(p + i + 2), vc));
+        }
+#endif
+        for (; i < n; ++i)
+            p[i] += c;
+    }
+
+    inline void mul_doubles(double* p, size_t n, double c)
+    {
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        const __m128d vc = _mm_set1_pd(c);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_pd(p + i,     _mm_mul_pd(_mm_loadu_pd(p + i),     vc));
+            _mm_storeu_pd(p + i + 2, _mm_mul_pd(_mm_loadu_pd(p + i + 2), vc));
+        }
+#endif
+        for (; i < n; ++i)
+            p[i] *= c;
+    }
+
+    // Sum of n doubles with four independent accumulators (eight lanes with SSE2), so the
+    // additions overlap instead of each waiting for the previous one. The order of the
+    // additions differs from a plain loop's, and so may the last bits of the result.
+    inline double sum_doubles(const double* p, size_t n)
+    {
+        size_t i = 0;
+        double total = 0;
+#if ZEN_HAS_SSE2
+        __m128d a0 = _mm_setzero_pd(), a1 = a0, a2 = a0, a3 = a0;
+        for (; i + 8 <= n; i += 8) {
+            a0 = _mm_add_pd(a0, _mm_loadu_pd(p + i));
+            a1 = _mm_add_pd(a1, _mm_loadu_pd(p + i + 2));
+            a2 = _mm_add_pd(a2, _mm_loadu_pd(p + i + 4));
+            a3 = _mm_add_pd(a3, _mm_loadu_pd(p + i + 6));
+        }
+        const __m128d a = _mm_add_pd(_mm_add_pd(a0, a1), _mm_add_pd(a2, a3));
+        total = _mm_cvtsd_f64(a) + _mm_cvtsd_f64(_mm_unpackhi_pd(a, a));
+#endif
+        for (; i < n; ++i)
+            total += p[i];
+        return total;
+    }
+
+    // Smallest and largest of n doubles, skipping NaNs (+inf and -inf when all are NaN)
+    inline void minmax_doubles(const double* p, size_t n, double& lo, double& hi)
+    {
+        size_t i = 0;
+        lo =  std::numeric_limits<double>::infinity();
+        hi = -std::numeric_limits<double>::infinity();
+#if ZEN_HAS_SSE2
+        // minpd/maxpd return their second operand when either one is NaN, so the data goes first
+        __m128d lo0 = _mm_set1_pd(lo), lo1 = lo0, hi0 = _mm_set1_pd(hi), hi1 = hi0;
+        for (; i + 4 <= n; i += 4) {
+            const __m128d v0 = _mm_loadu_pd(p + i), v1 = _mm_loadu_pd(p + i + 2);
+            lo0 = _mm_min_pd(v0, lo0);
+            lo1 = _mm_min_pd(v1, lo1);
+            hi0 = _mm_max_pd(v0, hi0);
+            hi1 = _mm_max_pd(v1, hi1);
+        }
+        const __m128d l = _mm_min_pd(lo0, lo1), h = _mm_max_pd(hi0, hi1);
+        lo = std::min(_mm_cvtsd_f64(l), _mm_cvtsd_f64(_mm_unpackhi_pd(l, l)));
+        hi = std::max(_mm_cvtsd_f64(h), _mm_cvtsd_f64(_mm_unpackhi_pd(h, h)));
+#endif
+        for (; i < n; ++i) {
+            if (p[i] < lo) lo = p[i];
+            if (p[i] > hi) hi = p[i];
+        }
+    }
+} // namespace internal
+
+// Points stored as a structure of arrays: all the x coordinates in one 64-byte aligned
+// array, all the y in another (and the z in a third). zen::points2d/points3d store whole
+// points one after the other, so a pass over one coordinate drags the others through the
+// cache too, and their loops can't be vectorized well. Here each coordinate is a plain
+// array of doubles, which translate(), scale() and transform() stream through two
+// lanes at a time with SSE2, and centroid() and bounding_box() reduce the same way.
+// Elements are read and written as whole points by value; xs(), ys() and zs() expose
+// the coordinate arrays themselves.
+// Example: zen::point_cloud3d cloud(points);   // from a zen::points3d
+//          cloud.translate({ 1, 0, 0 });
+//          auto [lo, hi] = cloud.bounding_box();
+template<size_t Dims>
+class point_cloud : private zen::stackonly
+{
+    ZEN_STATIC_ASSERT(Dims == 2 || Dims == 3, "zen::point_cloud IS EITHER 2D OR 3D");
+
+public:
+    using point_type = std::conditional_t<Dims == 2, point2d, point3d>;
+    using axis_type  = std::vector<double, internal::aligned_allocator<double, 64>>;
+
+    static constexpr size_t dimensions = Dims;
+
+    point_cloud() = default;
+
+    explicit point_cloud(size_t n) { resize(n); }
+
+    // From an array of structures, e.g. zen::points2d / zen::points3d
+    template<class Iterable> requires zen::is_iterable_v<Iterable>
+    explicit point_cloud(const Iterable& points)
+    {
+        if constexpr (requires { std::size(points); })
+            reserve(std::size(points));
+        for (const auto& p : points)
+            push_back(p);
+    }
+
+    size_t size()     const { return axes_[0].size(); }
+    bool   empty()    const { return axes_[0].empty(); }
+    bool   is_empty() const { return empty(); }
+
+    void reserve(size_t n) { for (auto& a : axes_) a.reserve(n); }
+    void resize(size_t n)  { for (auto& a : axes_) a.resize(n); }
+    void clear()           { for (auto& a : axes_) a.clear(); }
+
+    void push_back(const point_type& p)
+    {
+        const auto c = coords(p);
+        for (size_t k = 0; k < Dims; ++k)
+            axes_[k].push_back(c[k]);
+    }
+
+    point_type operator[](size_t i) const
+    {
+        if constexpr (Dims == 2) return point_type(axes_[0][i], axes_[1][i]);
+        else                     return point_type(axes_[0][i], axes_[1][i], axes_[2][i]);
+    }
+
+    point_type at(size_t i) const
+    {
+        if (i >= size())
+            throw std::out_of_range("POINT_CLOUD INDEX OUT OF RANGE");
+        return (*this)[i];
+    }
+
+    void set(size_t i, const point_type& p)
+    {
+        const auto c = coords(p);
+        for (size_t k = 0; k < Dims; ++k)
+            axes_[k][i] = c[k];
+    }
+
+    double*       xs()       { return axes_[0].data(); }
+    const double* xs() const { return axes_[0].data(); }
+    double*       ys()       { return axes_[1].data(); }
+    const double* ys() const { return axes_[1].data(); }
+    double*       zs()       requires (Dims == 3) { return axes_[2].data(); }
+    const double* zs() const requires (Dims == 3) { return axes_[2].data(); }
+
+    // Moves every point by offset
+    point_cloud& translate(const point_type& offset)
+    {
+        const auto c = coords(offset);
+        for (size_t k = 0; k < Dims; ++k)
+            internal::add_doubles(axes_[k].data(), size(), c[k]);
+        return *this;
+    }
+
+    // Scales every point by k about the origin, or by a different factor per axis
+    point_cloud& scale(const double k)
+    {
+        if constexpr (Dims == 2) return scale(point_type(k, k));
+        else                     return scale(point_type(k, k, k));
+    }
+
+    point_cloud& scale(const point_type& factors)
+    {
+        const auto c = coords(factors);
+        for (size_t k = 0; k < Dims; ++k)
+            internal::mul_doubles(axes_[k].data(), size(), c[k]);
+        return *this;
+    }
+
+    // Applies the affine transform m, row-major, with the translation in the last column:
+    // x' = m[0][0] * x + m[0][1] * y + ... + m[0][Dims]
+    point_cloud& transform(const std::array<std::array<double, Dims + 1>, Dims>& m)
+    {
+        const size_t n = size();
+        std::array<double*, Dims> p;
+        for (size_t k = 0; k < Dims; ++k)
+            p[k] = axes_[k].data();
+
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        // Two points per step, each row summed in the same order as in the scalar tail below
+        __m128d w[Dims][Dims + 1];
+        for (size_t r = 0; r < Dims; ++r)
+            for (size_t c = 0; c <= Dims; ++c)
+                w[r][c] = _mm_set1_pd(m[r][c]);
+        for (; i + 2 <= n; i += 2) {
+            __m128d in[Dims];
+            for (size_t k = 0; k < Dims; ++k)
+                in[k] = _mm_loadu_pd(p[k] + i);
+            for (size_t r = 0; r < Dims; ++r) {
+                __m128d acc = _mm_mul_pd(w[r][0], in[0]);
+                for (size_t c = 1; c < Dims; ++c)
+                    acc = _mm_add_pd(acc, _mm_mul_pd(w[r][c], in[c]));
+                _mm_storeu_pd(p[r] + i, _mm_add_pd(acc, w[r][Dims]));
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            std::array<double, Dims> in;
+            for (size_t k = 0; k < Dims; ++k)
+                in[k] = p[k][i];
+            for (size_t r = 0; r < Dims; ++r) {
+                double acc = m[r][0] * in[0];
+                for (size_t c = 1; c < Dims; ++c)
+                    acc += m[r][c] * in[c];
+                p[r][i] = acc + m[r][Dims];
+            }
+        }
+        return *this;
+    }
+
+    point_type centroid() const
+    {
+        if (empty())
+            throw std::invalid_argument("CENTROID OF AN EMPTY point_cloud");
+        std::array<double, Dims> c;
+        for (size_t k = 0; k < Dims; ++k)
+            c[k] = internal::sum_doubles(axes_[k].data(), size()) / static_cast<double>(size());
+        return make_point(c);
+    }
+
+    // The smallest and the largest corner of the axis-aligned box around all points
+    std::pair<point_type, point_type> bounding_box() const
+    {
+        if (empty())
+            throw std::invalid_argument("BOUNDING BOX OF AN EMPTY point_cloud");
+        std::array<double, Dims> lo, hi;
+        for (size_t k = 0; k < Dims; ++k)
+            internal::minmax_doubles(axes_[k].data(), size(), lo[k], hi[k]);
+        return { make_point(lo), make_point(hi) };
+    }
+
+    // Back to an array of structures
+    zen::vector<point_type, std::allocator<point_type>> to_points() const
+    {
+        zen::vector<point_type, std::allocator<point_type>> points;
+        points.reserve(size());
+        for (size_t i = 0; i < size(); ++i)
+            points.push_back((*this)[i]);
+        return points;
+    }
+
+private:
+    static std::array<double, Dims> coords(const point_type& p)
+    {
+        if constexpr (Dims == 2) return { p.x(), p.y() };
+        else                     return { p.x(), p.y(), p.z() };
+    }
+
+    static point_type make_point(const std::array<double, Dims>& c)
+    {
+        if constexpr (Dims == 2) return point_type(c[0], c[1]);
+        else                     return point_type(c[0], c[1], c[2]);
+    }
+
+    std::array<axis_type, Dims> axes_;
+};
+
+using point_cloud2d = point_cloud<2>;
+using point_cloud3d = point_cloud<3>;
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::queue
+
+template<class T, class C = std::deque<T>>
+class queue : public std::queue<T, C>, private zen::stackonly
+{
+public:
+    using std::queue<T, C>::queue; // inherit constructors, has to be explicit
+
+    queue(const std::queue<T, C>& q) : std::queue<T, C>(q) {}
+
+    // Fills the underlying container in one go, moving from an rvalue (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::queue<T, C>>
+    queue(Iterable&& src)
+    {
+        zen::ingest(this->c, std::forward<Iterable>(src));
+    }
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = queue<T, C>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::priority_queue
+
+template<
+    class T,
+    class C = std::vector<T>,
+    class L = std::less<typename C::value_type>
+>
+class priority_queue : public std::priority_queue<T, C, L>, private zen::stackonly
+{
+public:
+    using std::priority_queue<T, C, L>::priority_queue; // inherit constructors, has to be explicit
+
+    priority_queue(const std::priority_queue<T, C, L>& q) : std::priority_queue<T, C, L>(q) {}
+
+    // Fills the underlying container in one go (see zen::ingest) and heapifies it with
+    // std::make_heap: O(n) comparisons rather than the O(n log n) of pushing one by one
+    template<class Iterable> requires internal::ingestible<Iterable, std::priority_queue<T, C, L>>
+    priority_queue(Iterable&& src)
+    {
+        zen::ingest(this->c, std::forward<Iterable>(src));
+        std::make_heap(this->c.begin(), this->c.end(), this->comp);
+    }
+
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = priority_queue<T, C, L>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::dary_heap
+
+// A priority queue on a d-ary heap: every node has D children instead of 2, so the tree is
+// log2(D) times shallower. A push compares against log_D(n) parents, and a pop looks at D
+// siblings per level, which sit next to each other in memory (4 or 8 ints make up a
+// fraction of one cache line). Deep heaps thus take far fewer cache misses than with the
+// binary heap of std::priority_queue. Like std::priority_queue, top() is the largest
+// element by L (use std::greater<T> for a min-heap).
+// Example: zen::dary_heap<int, 4, std::greater<int>> timers = { 30, 10, 20 };
+//          timers.top(); // 10
+template<class T, size_t D = 4, class L = std::less<T>, class C = std::vector<T>>
+class dary_heap : private zen::stackonly
+{
+    static_assert(D >= 2, "zen::dary_heap NEEDS AT LEAST TWO CHILDREN PER NODE");
+
+public:
+    using value_type      = T;
+    using container_type  = C;
+    using value_compare   = L;
+    using size_type       = size_t;
+    using const_reference = const T&;
+
+    static constexpr size_t arity = D;
+
+    dary_heap() = default;
+
+    explicit dary_heap(const L& less) : less_(less) {}
+
+    // Takes the elements in any order and heapifies them in O(n)
+    explicit dary_heap(C items, const L& less = L()) : items_(std::move(items)), less_(less) { heapify(); }
+
+    template<class It>
+    dary_heap(It first, It last, const L& less = L()) : items_(first, last), less_(less) { heapify(); }
+
+    dary_heap(std::initializer_list<T> init, const L& less = L()) : dary_heap(init.begin(), init.end(), less) {}
+
+    // Like zen::priority_queue, starts out with the elements of c
+    template<class Iterable> requires zen::is_iterable_v<Iterable>
+    explicit dary_heap(const Iterable& c) : dary_heap(std::begin(c), std::end(c)) {}
+
+    const T& top()      const { return items_.front(); }
+    size_t   size()     const { return items_.size(); }
+    bool     empty()    const { return items_.empty(); }
+    bool     is_empty() const { return empty(); }
+
+    void reserve(size_t n) { items_.reserve(n); }
+    void clear()           { items_.clear(); }
+
+    void push(const T& x) { emplace(x); }
+    void push(T&& x)      { emplace(std::move(x)); }
+
+    template<class... Args>
+    void emplace(Args&&... args)
+    {
+        items_.emplace_back(std::forward<Args>(args)...);
+        sift_up(items_.size() - 1);
+    }
+
+    void pop()
+    {
+        if (items_.size() > 1) {
+            T last = std::move(items_.back());
+            items_.pop_back();
+            sift_down(0, std::move(last));
+        }
+        else {
+            items_.pop_back();
+        }
+    }
+
+    // pop() followed by push(x), with one sift instead of two. The usual step of a top-k
+    // filter or of a scheduler that re-arms the timer it just fired. On an empty heap,
+    // where there is nothing to pop, it is just push(x).
+    void replace_top(T x)
+    {
+        if (items_.empty())
+            push(std::move(x));
+        else
+            sift_down(0, std::move(x));
+    }
+
+    // Hands over the elements, in heap order, and leaves the heap empty
+    C take() { return std::exchange(items_, C()); }
+
+private:
+    void heapify()
+    {
+        if (items_.size() < 2)
+            return;
+        for (size_t i = (items_.size() - 2) / D + 1; i-- > 0;) {
+            T x = std::move(items_[i]);
+            sift_down(i, std::move(x));
+        }
+    }
+
+    // The element at i moves up past every parent it's bigger than
+    void sift_up(size_t i)
+    {
+        T x = std::move(items_[i]);
+        while (i > 0) {
+            const size_t parent = (i - 1) / D;
+            if (!less_(items_[parent], x))
+                break;
+            items_[i] = std::move(items_[parent]);
+            i = parent;
+        }
+        items_[i] = std::move(x);
+    }
+
+    // Fills the hole at i with x, pulling the largest child up while it's bigger than x
+    void sift_down(size_t i, T x)
+    {
+        const size_t n = items_.size();
+        for (;;) {
+            const size_t first = i * D + 1;
+            if (first >= n)
+                break;
+            const size_t last = std::min(first + D, n);
+            size_t best = first;
+            for (size_t c = first + 1; c < last; ++c)
+                if (less_(items_[best], items_[c]))
+                    best = c;
+            if (!less_(x, items_[best]))
+                break;
+            items_[i] = std::move(items_[best]);
+            i = best;
+        }
+        items_[i] = std::move(x);
+    }
+
+    C items_;
+    L less_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::spsc_queue
+
+// A bounded lock-free queue for exactly one producer thread and one consumer thread.
+// It's a ring buffer where each side owns its index, on its own cache line, and keeps
+// a cached copy of the other side's index: the shared index is only reloaded when the
+// cached one says the ring looks full (producer) or empty (consumer).
+// The capacity is rounded up to a power of two.
+// Example: zen::spsc_queue<job> q(1024);
+//          producer thread: q.push(j); // waits while full
+//          consumer thread: if (auto j = q.try_pop()) run(*j);
+template<class T>
+class spsc_queue : private zen::stackonly
+{
+public:
+    using value_type = T;
+
+    explicit spsc_queue(size_t capacity)
+        : capacity_(std::bit_ceil(std::max<size_t>(capacity, 2)))
+        , slots_(std::allocator<T>().allocate(capacity_)) {}
+
+    // Like zen::queue, starts out with the elements of c (with room for at least `capacity`)
+    template<class Iterable> requires zen::is_iterable_v<Iterable>
+    explicit spsc_queue(const Iterable& c, size_t capacity = 0)
+        : spsc_queue(std::max<size_t>(capacity, static_cast<size_t>(std::distance(std::begin(c), std::end(c)))))
+    {
+        for (const auto& x : c)
+            try_push(x);
+    }
+
+    spsc_queue(const spsc_queue&)            = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    ~spsc_queue()
+    {
+        for (size_t i = tail_.load(std::memory_order_relaxed); i != head_.load(std::memory_order_relaxed); ++i)
+            std::destroy_at(slots_ + (i & (capacity_ - 1)));
+        std::allocator<T>().deallocate(slots_, capacity_);
+    }
+
+    // Producer side: false when the queue is full
+    bool try_push(const T& x) { return try_emplace(x); }
+    bool try_push(T&& x)      { return try_emplace(std::move(x)); }
+
+    template<class... Args>
+    bool try_emplace(Args&&... args)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == capacity_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == capacity_)
+                return false;
+        }
+        std::construct_at(slots_ + (head & (capacity_ - 1)), std::forward<Args>(args)...);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: false (or an empty optional) when the queue is empty
+    bool             try_pop(T& out) { return pop_with([&out](T&& x) { out = std::move(x); }); }
+    std::optional<T> try_pop()       { std::optional<T> out; pop_with([&out](T&& x) { out.emplace(std::move(x)); }); return out; }
+
+    // Blocking versions that yield the thread while the queue is full or empty
+    void push(const T& x) { while (!try_push(x)) std::this_thread::yield(); }
+    void push(T&& x)      { while (!try_push(std::move(x))) std::this_thread::yield(); }
+
+    T pop()
+    {
+        for (;;) {
+            if (auto x = try_pop())
+                return std::move(*x);
+            std::this_thread::yield();
+        }
+    }
+
+    // Only a snapshot while the other side is running
+    size_t size()     const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+    bool   empty()    const { return size() == 0; }
+    bool   is_empty() const { return empty(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    template<class Take>
+    bool pop_with(Take take)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_)
+                return false;
+        }
+        T* const slot = slots_ + (tail & (capacity_ - 1));
+        take(std::move(*slot));
+        std::destroy_at(slot);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    const size_t capacity_;
+    T* const     slots_;
+
+    alignas(64) std::atomic<size_t> head_{0}; // written by the producer only
+    size_t cached_tail_ = 0;                  // the producer's last look at tail_
+    alignas(64) std::atomic<size_t> tail_{0}; // written by the consumer only
+    size_t cached_head_ = 0;                  // the consumer's last look at head_
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::mpmc_queue
+
+// A bounded lock-free queue for any number of producer and consumer threads (Dmitry
+// Vyukov's design). Every slot carries a sequence number that says whether it's ready to
+// be written or read in the current lap, so a push or a pop is one CAS on the shared
+// position plus a store to the slot, and threads only contend on those two positions.
+// The capacity is rounded up to a power of two.
+// Example: zen::mpmc_queue<task> q(4096);
+//          any thread: q.push(t);        // waits while full
+//          any thread: task t = q.pop(); // waits while empty
+template<class T>
+class mpmc_queue : private zen::stackonly
+{
+public:
+    using value_type = T;
+
+    explicit mpmc_queue(size_t capacity)
+        : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+        , cells_(new cell[mask_ + 1])
+    {
+        for (size_t i = 0; i <= mask_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Like zen::queue, starts out with the elements of c (with room for at least `capacity`)
+    template<class Iterable> requires zen::is_iterable_v<Iterable>
+    explicit mpmc_queue(const Iterable& c, size_t capacity = 0)
+        : mpmc_queue(std::max<size_t>(capacity, static_cast<size_t>(std::distance(std::begin(c), std::end(c)))))
+    {
+        for (const auto& x : c)
+            try_push(x);
+    }
+
+    mpmc_queue(const mpmc_queue&)            = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    ~mpmc_queue()
+    {
+        while (pop_with([](T&&) {})) {}
+    }
+
+    bool try_push(const T& x) { return try_emplace(x); }
+    bool try_push(T&& x)      { return try_emplace(std::move(x)); }
+
+    // False when the queue is full
+    template<class... Args>
+    bool try_emplace(Args&&... args)
     {
-        return std::find_if(my::begin(), my::end(), p) != my::end();
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        cell*  c;
+        for (;;) {
+            c = &cells_[pos & mask_];
+            const auto lap = static_cast<std::ptrdiff_t>(c->sequence.load(std::memory_order_acquire) - pos);
+            if (lap == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (lap < 0) {
+                return false; // the slot still holds last lap's element
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        std::construct_at(c->value(), std::forward<Args>(args)...);
+        c->sequence.store(pos + 1, std::memory_order_release);
+        return true;
     }
-    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
 
-    bool is_empty() const { return my::empty(); }
+    // False (or an empty optional) when the queue is empty
+    bool             try_pop(T& out) { return pop_with([&out](T&& x) { out = std::move(x); }); }
+    std::optional<T> try_pop()       { std::optional<T> out; pop_with([&out](T&& x) { out.emplace(std::move(x)); }); return out; }
 
-private:
-    using my = forward_list<T, A>;
-};
+    // Blocking versions that yield the thread while the queue is full or empty
+    void push(const T& x) { while (!try_push(x)) std::this_thread::yield(); }
+    void push(T&& x)      { while (!try_push(std::move(x))) std::this_thread::yield(); }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::in
+    T pop()
+    {
+        for (;;) {
+            if (auto x = try_pop())
+                return std::move(*x);
+            std::this_thread::yield();
+        }
+    }
 
-// Declarative range-for loop. Note that apart from an intuitive
-// reading, "in" can also be thought of standing for "interval".
-// Example: for (int i : zen::in(5))         // from  0 to  5
-// Example: for (int i : zen::in(1, 10))     // from  1 to 10
-// Example: for (int i : zen::in(10, 1, -1)) // from 10 to  1, step -1
-class in {
-public:
-    in(int end)
-        : begin_(0), end_(end), step_(1) {}
+    // Only a snapshot while other threads are running
+    size_t size() const
+    {
+        const size_t head = enqueue_pos_.load(std::memory_order_acquire);
+        const size_t tail = dequeue_pos_.load(std::memory_order_acquire);
+        return head > tail ? head - tail : 0;
+    }
 
-    in(int begin, int end, int step = 1)
-        : begin_(begin), end_(end), step_(step) {}
+    bool   empty()    const { return size() == 0; }
+    bool   is_empty() const { return empty(); }
+    size_t capacity() const { return mask_ + 1; }
 
-    class iterator {
-    public:
-        iterator(int n = 0, int step = 1) : n_(n), step_(step) {}
-        iterator& operator++() { n_ += step_; return *this; }
-        const int& operator*()             const { return n_; }
-        bool operator!=(const iterator& x) const {
-            return (step_ > 0) ? (n_ < x.n_) : (n_ > x.n_);
-        }
-    private:
-        int n_;
-        int step_;
+private:
+    struct cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() { return reinterpret_cast<T*>(storage); }
     };
 
-    iterator begin() const { return iterator(begin_, step_); }
-    iterator end()   const { return iterator(end_,   step_); }
+    template<class Take>
+    bool pop_with(Take take)
+    {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        cell*  c;
+        for (;;) {
+            c = &cells_[pos & mask_];
+            const auto lap = static_cast<std::ptrdiff_t>(c->sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (lap == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (lap < 0) {
+                return false; // nothing written to the slot in this lap yet
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        take(std::move(*c->value()));
+        std::destroy_at(c->value());
+        c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+    }
 
-private:
-    int begin_;
-    int end_;
-    int step_;
+    const size_t                  mask_;
+    const std::unique_ptr<cell[]> cells_;
+
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
 };
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::list
+///////////////////////////////////////////////////////////////////////////////////////////// zen::set
 
-template<class T, class A = std::allocator<T>>
-class list : public std::list<T, A>, private zen::stackonly
+template<class K, class C = internal::default_less<K>, class A = std::allocator<K>>
+class set : public std::set<K, C, A>, private zen::stackonly
 {
 public:
-    using std::list<T, A>::list; // inherit constructors, has to be explicit
+    using std::set<K, C, A>::set; // inherit constructors, has to be explicit
 
-    list(const std::list<T, A>& x) : std::list<T, A>(x) {}
+    set(const std::set<K, C, A>& u) : std::set<K, C, A>(u) {}
 
-    template<class Pred>
-    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
-        contains(Pred p) const
-    {
-        return std::find_if(my::begin(), my::end(), p) != my::end();
-    }
-    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
+    template<class Kx, class Cx, class Ax>
+    set(const std::set<Kx, Cx, Ax>& u) : std::set<K, C, A>(u.begin(), u.end()) {}
+
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::set<K, C, A>>
+    explicit set(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
 
     bool is_empty() const { return my::empty(); }
 
 private:
-    using my = list<T, A>;
+    using my = set<K, C, A>;
 };
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::map
+///////////////////////////////////////////////////////////////////////////////////////////// zen::multiset
 
-template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<const K, V>>>
-class map : public std::map<K, V, C, A>, private zen::stackonly
+template<class K, class C = internal::default_less<K>, class A = std::allocator<K>>
+class multiset : public std::multiset<K, C, A>, private zen::stackonly
 {
 public:
-    using std::map<K, V, C, A>::map; // inherit constructors, has to be explicit
+    using std::multiset<K, C, A>::multiset; // inherit constructors, has to be explicit
 
-    map(const std::map<K, V, C, A>& m) : std::map<K, V, C, A>(m) {}
+    multiset(const std::multiset<K, C, A>& u) : std::multiset<K, C, A>(u) {}
 
-    template<class Kx, class Vx, class Cx, class Ax>
-    map(const std::map<Kx, Vx, Cx, Ax>& m) : std::map<K, V, C, A>(m.begin(), m.end()) {}
+    template<class Kx, class Cx, class Ax>
+    multiset(const std::multiset<Kx, Cx, Ax>& u) : std::multiset<K, C, A>(u.begin(), u.end()) {}
 
     bool is_empty() const { return my::empty(); }
 
 private:
-    using my = map<K, V, C, A>;
+    using my = multiset<K, C, A>;
 };
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::multimap
-
-template<class K, class V, class C = std::less<K>, class A = std::allocator<std::pair<const K, V>>>
-class multimap : public std::multimap<K, V, C, A>, private zen::stackonly
+///////////////////////////////////////////////////////////////////////////////////////////// zen::small_vector
+
+// A vector that keeps up to N elements inside itself and only goes to the heap once it
+// grows past them, so the many short-lived 2 to 8 element vectors cost no allocation.
+// It's a sequence container with the usual std::vector surface (push_back, emplace_back,
+// insert, erase, resize, reserve...) plus the zen::vector helpers contains() and is_empty().
+// Unlike std::vector, moving an inline small_vector moves its elements one by one,
+// so iterators into the source don't survive the move.
+// Example: zen::small_vector<int, 4> v = { 1, 2, 3 }; // no allocation
+//          v.push_back(4); v.push_back(5);             // spills to the heap
+template<class T, size_t N, class A = std::allocator<T>>
+class small_vector : private zen::stackonly
 {
+    static_assert(N > 0, "zen::small_vector NEEDS ROOM FOR AT LEAST ONE INLINE ELEMENT");
+
 public:
-    using std::multimap<K, V, C, A>::multimap; // inherit constructors, has to be explicit
+    using value_type             = T;
+    using allocator_type         = A;
+    using size_type              = size_t;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T&;
+    using const_reference        = const T&;
+    using pointer                = T*;
+    using const_pointer          = const T*;
+    using iterator               = T*;
+    using const_iterator         = const T*;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    multimap(const std::multimap<K, V, C, A>& m) : std::multimap<K, V, C, A>(m) {}
+    static constexpr size_t inline_capacity = N;
 
-    template<class Kx, class Vx, class Cx, class Ax>
-    multimap(const std::multimap<Kx, Vx, Cx, Ax>& m) : std::multimap<K, V, C, A>(m.begin(), m.end()) {}
+    small_vector() = default;
 
-    // std::map::operator[] is not defined, but
-    // zen::map::operator[] returns an std::vector
-    // composed of values corresponding to the parameter key.
-    std::vector<V> operator[](const K& key) {
-        auto range = my::equal_range(key);
-        std::vector<V> values;
-        for (auto it = range.first; it != range.second; ++it) {
-            values.push_back(it->second);
+    explicit small_vector(size_t n) { resize(n); }
+
+    small_vector(size_t n, const T& value) { resize(n, value); }
+
+    template<std::input_iterator It>
+    small_vector(It first, It last) { append(first, last); }
+
+    small_vector(std::initializer_list<T> init) { append(init.begin(), init.end()); }
+
+    small_vector(const small_vector& other) { append(other.begin(), other.end()); }
+
+    small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>) { steal(other); }
+
+    small_vector(const std::vector<T, A>& v) { append(v.begin(), v.end()); }
+
+    small_vector& operator=(const small_vector& other)
+    {
+        if (this != &other) {
+            clear();
+            append(other.begin(), other.end());
         }
-        return values;
+        return *this;
     }
 
-    bool is_empty() const { return my::empty(); }
+    small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    small_vector& operator=(std::initializer_list<T> init)
+    {
+        clear();
+        append(init.begin(), init.end());
+        return *this;
+    }
+
+    ~small_vector() { release(); }
+
+    iterator               begin()         { return data_; }
+    const_iterator         begin()   const { return data_; }
+    const_iterator         cbegin()  const { return data_; }
+    iterator               end()           { return data_ + size_; }
+    const_iterator         end()     const { return data_ + size_; }
+    const_iterator         cend()    const { return data_ + size_; }
+    reverse_iterator       rbegin()        { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin()  const { return const_reverse_iterator(end()); }
+    reverse_iterator       rend()          { return reverse_iterator(begin()); }
+    const_reverse_iterator rend()    const { return const_reverse_iterator(begin()); }
+
+    T*       data()       { return data_; }
+    const T* data() const { return data_; }
+
+    size_t size()      const { return size_; }
+    size_t capacity()  const { return capacity_; }
+    bool   empty()     const { return size_ == 0; }
+    bool   is_empty()  const { return empty(); }
+
+    // True while the elements still live in the inline buffer
+    bool is_inline() const { return data_ == inline_data(); }
+
+    T&       operator[](size_t i)       { return data_[i]; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    T& at(size_t i)
+    {
+        if (i >= size_)
+            throw std::out_of_range("SMALL_VECTOR INDEX OUT OF RANGE");
+        return data_[i];
+    }
+
+    const T& at(size_t i) const { return const_cast<small_vector*>(this)->at(i); }
+
+    T&       front()       { return data_[0]; }
+    const T& front() const { return data_[0]; }
+    T&       back()        { return data_[size_ - 1]; }
+    const T& back()  const { return data_[size_ - 1]; }
+
+    void reserve(size_t n)
+    {
+        if (n > capacity_)
+            reallocate(n);
+    }
+
+    // Moves the elements back into the inline buffer when they fit, or into an exact-size heap block
+    void shrink_to_fit()
+    {
+        if (!is_inline() && size_ < capacity_)
+            reallocate(size_);
+    }
+
+    void clear()
+    {
+        std::destroy_n(data_, size_);
+        size_ = 0;
+    }
+
+    void push_back(const T& x) { emplace_back(x); }
+    void push_back(T&& x)      { emplace_back(std::move(x)); }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (size_ == capacity_)
+            return grow_and_emplace_back(std::forward<Args>(args)...);
+        T* p = std::construct_at(data_ + size_, std::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    void pop_back()
+    {
+        std::destroy_at(data_ + size_ - 1);
+        --size_;
+    }
+
+    void resize(size_t n)                 { resize_with(n, [this] { std::uninitialized_value_construct_n(data_ + size_, 1); }); }
+    void resize(size_t n, const T& value) { resize_with(n, [&] { std::uninitialized_fill_n(data_ + size_, 1, value); }); }
+
+    template<class... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const size_t i = static_cast<size_t>(pos - data_);
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(data_ + i, data_ + size_ - 1, data_ + size_);
+        return data_ + i;
+    }
+
+    iterator insert(const_iterator pos, const T& x) { return emplace(pos, x); }
+    iterator insert(const_iterator pos, T&& x)      { return emplace(pos, std::move(x)); }
+
+    template<std::input_iterator It>
+    iterator insert(const_iterator pos, It first, It last)
+    {
+        const size_t i = static_cast<size_t>(pos - data_), old_size = size_;
+        append(first, last);
+        std::rotate(data_ + i, data_ + old_size, data_ + size_);
+        return data_ + i;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* const f = data_ + (first - data_);
+        T* const l = data_ + (last - data_);
+        if (f != l) {
+            T* const new_end = std::move(l, end(), f);
+            std::destroy(new_end, end());
+            size_ = static_cast<size_t>(new_end - data_);
+        }
+        return f;
+    }
+
+    template<class Pred>
+    typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
+        contains(Pred p) const
+    {
+        return std::find_if(begin(), end(), p) != end();
+    }
+
+    bool contains(const T& x) const { return internal::find_value(begin(), end(), x) != end(); }
+
+    friend bool operator==(const small_vector& a, const small_vector& b) { return std::equal(a.begin(), a.end(), b.begin(), b.end()); }
+    friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+    friend bool operator< (const small_vector& a, const small_vector& b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
 
 private:
-    using my = multimap<K, V, C, A>;
-};
+    T*       inline_data()       { return reinterpret_cast<T*>(inline_); }
+    const T* inline_data() const { return reinterpret_cast<const T*>(inline_); }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::point2d
+    // Grows by half again (at least to the requested size), like most std::vector implementations
+    size_t grown_capacity(size_t needed) const { return std::max(needed, capacity_ + capacity_ / 2); }
 
-class point2d : public std::pair<double, double> {
-public:
-    point2d(double xc = 0.0, double yc = 0.0)    : std::pair<double, double>(xc, yc)       {}
-    point2d(const std::pair<double, double>&  p) : std::pair<double, double>(p)            {}
-    point2d(      std::pair<double, double>&& p) : std::pair<double, double>(std::move(p)) {}
+    // Moves the elements to a heap block of exactly new_capacity,
+    // or back to the inline buffer when new_capacity is at most N
+    void reallocate(size_t new_capacity)
+    {
+        T* const fresh = new_capacity <= N ? inline_data() : std::allocator_traits<A>::allocate(alloc_, new_capacity);
+        if (fresh == data_)
+            return;
+        try {
+            relocate(data_, size_, fresh);
+        }
+        catch (...) {
+            if (fresh != inline_data())
+                std::allocator_traits<A>::deallocate(alloc_, fresh, new_capacity);
+            throw;
+        }
+        std::destroy_n(data_, size_);
+        free_heap();
+        data_     = fresh;
+        capacity_ = std::max(new_capacity, N);
+    }
 
-    // Allows conversions from other arithmetic pair types
-    template <class T, class U, typename std::enable_if<
-                                         std::is_arithmetic_v<T> &&
-                                         std::is_arithmetic_v<U>, int>::type = 0>
-    point2d(const std::pair<T, U>& p)
-        : std::pair<double, double>(
-            static_cast<double>(p.first),
-            static_cast<double>(p.second)
-        )
-    {}
+    // The new element is constructed before the old ones move, since args may refer to one of them
+    template<class... Args>
+    T& grow_and_emplace_back(Args&&... args)
+    {
+        const size_t new_capacity = grown_capacity(size_ + 1);
+        T* const     fresh        = std::allocator_traits<A>::allocate(alloc_, new_capacity);
+        T*           p            = nullptr;
+        try {
+            p = std::construct_at(fresh + size_, std::forward<Args>(args)...);
+            relocate(data_, size_, fresh);
+        }
+        catch (...) {
+            if (p)
+                std::destroy_at(p);
+            std::allocator_traits<A>::deallocate(alloc_, fresh, new_capacity);
+            throw;
+        }
+        std::destroy_n(data_, size_);
+        free_heap();
+        data_     = fresh;
+        capacity_ = new_capacity;
+        ++size_;
+        return *p;
+    }
 
-    point2d& operator=(const std::pair<double, double>& p) {
-        this->first  = p.first;
-        this->second = p.second;
-        return *this;
+    // Moves when that can't throw (or when T can't be copied), copies otherwise,
+    // so a throwing move leaves the source untouched, as std::vector does
+    static void relocate(T* from, size_t n, T* to)
+    {
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            std::uninitialized_move_n(from, n, to);
+        else
+            std::uninitialized_copy_n(from, n, to);
     }
 
-    point2d& operator=(std::pair<double, double>&& p) {
-        this->first  = std::move(p.first);
-        this->second = std::move(p.second);
-        return *this;
+    template<class It>
+    void append(It first, It last)
+    {
+        if constexpr (std::forward_iterator<It>)
+            reserve(size_ + static_cast<size_t>(std::distance(first, last)));
+        for (; first != last; ++first)
+            emplace_back(*first);
     }
 
-    // Returning reference to the member is deliberate since
-    // x() and y() are simply meant to be a convenience alias
-    // interface to avoid writing '.first' or '.second' 
-    constexpr double& x()       { return this->first;  }
-    constexpr double& y()       { return this->second; }
-    constexpr double  x() const { return this->first;  }
-    constexpr double  y() const { return this->second; }
+    template<class Construct>
+    void resize_with(size_t n, Construct construct_one)
+    {
+        if (n < size_) {
+            std::destroy(data_ + n, end());
+            size_ = n;
+            return;
+        }
+        reserve(n);
+        while (size_ < n) {
+            construct_one();
+            ++size_;
+        }
+    }
+
+    // Takes other's heap block as is, or moves its inline elements one by one
+    void steal(small_vector& other)
+    {
+        if (other.is_inline()) {
+            std::uninitialized_move_n(other.data_, other.size_, data_);
+            size_ = other.size_;
+            other.clear();
+        }
+        else {
+            data_     = std::exchange(other.data_,     other.inline_data());
+            size_     = std::exchange(other.size_,     0);
+            capacity_ = std::exchange(other.capacity_, N);
+        }
+    }
+
+    void free_heap()
+    {
+        if (!is_inline())
+            std::allocator_traits<A>::deallocate(alloc_, data_, capacity_);
+    }
+
+    void release()
+    {
+        std::destroy_n(data_, size_);
+        free_heap();
+        data_     = inline_data();
+        size_     = 0;
+        capacity_ = N;
+    }
+
+    alignas(T) unsigned char  inline_[N * sizeof(T)];
+    T*                        data_     = inline_data();
+    size_t                    size_     = 0;
+    size_t                    capacity_ = N;
+    [[no_unique_address]] A   alloc_;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::stack
+
+template<class T, class C = std::deque<T>>
+class stack : public std::stack<T, C>, private zen::stackonly
+{
+public:
+    using std::stack<T, C>::stack; // inherit constructors, has to be explicit
+
+    stack(const std::stack<T, C>& q) : std::stack<T, C>(q) {}
+        
+    bool is_empty() const { return my::empty(); }
+
+private:
+    using my = stack<T, C>;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////// zen::string
+
+namespace internal {
+    // Character classes as defined by the "C" locale (the default unless std::setlocale()
+    // is called), one bit per class, indexed by the unsigned value of a char. Unlike
+    // std::isalpha() and friends, a table lookup is locale-free, branch-free and
+    // well-defined for negative chars.
+    enum char_class : unsigned char {
+        cc_alpha = 1 << 0,
+        cc_digit = 1 << 1,
+        cc_space = 1 << 2,
+        cc_print = 1 << 3,
+        cc_lower = 1 << 4,
+        cc_upper = 1 << 5,
+        cc_alnum = cc_alpha | cc_digit,
+    };
 
-    friend point2d operator+(const point2d& a, const point2d& b) { return point2d(a.x() + b.x(), a.y() + b.y()); }
-    friend point2d operator-(const point2d& a, const point2d& b) { return point2d(a.x() - b.x(), a.y() - b.y()); }
-    friend point2d operator*(const point2d& a, const double   k) { return point2d(a.x() * k, a.y() * k); }
-    friend bool   operator==(const point2d& a, const point2d& b) { return a.x() == b.x() && a.y() == b.y(); }
-    friend bool   operator!=(const point2d& a, const point2d& b) { return !(a == b); }
-    friend point2d operator/(const point2d& a, double k) {
-        if (k != 0) {
-            return point2d(a.x() / k, a.y() / k);
-        } else {
-            throw std::invalid_argument("ATTEMPTED DIVISION BY ZERO FOR point2d");
+    constexpr std::array<unsigned char, 256> make_char_classes()
+    {
+        std::array<unsigned char, 256> t{};
+        for (int c = 0; c < 256; ++c) {
+            if ('a' <= c && c <= 'z')             t[c] |= cc_alpha | cc_lower;
+            if ('A' <= c && c <= 'Z')             t[c] |= cc_alpha | cc_upper;
+            if ('0' <= c && c <= '9')             t[c] |= cc_digit;
+            if (c == ' ' || ('\t' <= c && c <= '\r')) t[c] |= cc_space;
+            if (0x20 <= c && c <= 0x7E)           t[c] |= cc_print;
         }
+        return t;
     }
-};
-
-///////////////////////////////////////////////////////////////////////////////////////////// zen::point3d
 
-class point3d : public point2d {
-public:
-    point3d(double xc = 0.0, double yc = 0.0, double zc = 0.0) : point2d(xc, yc), z_(zc) {}
+    inline constexpr std::array<unsigned char, 256> char_classes = make_char_classes();
 
-    point3d(const point2d& p, double zc = 0.0) : point2d(p), z_(zc) {}
+    inline bool is_class(char c, unsigned char mask) { return char_classes[static_cast<unsigned char>(c)] & mask; }
 
-    template <class T, class U, class V, typename std::enable_if<
-                                                  std::is_arithmetic_v<T> &&
-                                                  std::is_arithmetic_v<U> &&
-                                                  std::is_arithmetic_v<V>, int>::type = 0>
-    point3d(const std::tuple<T, U, V>& p)
-        : point2d(std::get<0>(p), std::get<1>(p)),
-           z_(static_cast<double>(std::get<2>(p)))
-    {}
+#if ZEN_HAS_SSE2
+    // Signed byte range check; bytes >= 0x80 are negative and therefore never in an ASCII range
+    inline __m128i in_range(__m128i v, char lo, char hi)
+    {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+    }
 
-    point3d& operator=(const std::pair<double, double>& p) {
-        point2d::operator=(p);            // inherit behavior for x and y
-        z_ = 0;                           // reset to default
-        return *this;
+    inline __m128i class_mask(__m128i v, unsigned char cls)
+    {
+        __m128i m = _mm_setzero_si128();
+        if (cls & cc_lower) m = _mm_or_si128(m, in_range(v, 'a', 'z'));
+        if (cls & cc_upper) m = _mm_or_si128(m, in_range(v, 'A', 'Z'));
+        if (cls & cc_alpha) m = _mm_or_si128(m, in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'));
+        if (cls & cc_digit) m = _mm_or_si128(m, in_range(v, '0', '9'));
+        if (cls & cc_space) m = _mm_or_si128(m, _mm_or_si128(in_range(v, '\t', '\r'), _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))));
+        if (cls & cc_print) m = _mm_or_si128(m, in_range(v, 0x20, 0x7E));
+        return m;
     }
+#endif
 
-    point3d& operator=(std::pair<double, double>&& p) {
-        point2d::operator=(std::move(p)); // inherit behavior for x and y
-        z_ = 0;                           // reset to default
-        return *this;
+    // True if every char of [s, s + n) belongs to at least one of the classes in 'cls'
+    inline bool all_of_class(const char* s, size_t n, unsigned char cls)
+    {
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        for (; i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if (_mm_movemask_epi8(class_mask(v, cls)) != 0xFFFF)
+                return false;
+        }
+#else
+        // Accumulate a whole block before testing to keep the loop free of early-exit branches
+        for (; i + 64 <= n; i += 64) {
+            unsigned char acc = cls;
+            for (size_t j = 0; j < 64; ++j)
+                acc &= (char_classes[static_cast<unsigned char>(s[i + j])] & cls) ? cls : 0;
+            if (acc != cls)
+                return false;
+        }
+#endif
+        for (; i < n; ++i)
+            if (!is_class(s[i], cls))
+                return false;
+        return true;
     }
 
-    // Returning reference to the member is deliberate since
-    // x(), y() and z() are simply meant to be a convenience alias
-    // interface to avoid writing '->first', '->second' or '->z_'
-    constexpr double& z()       { return z_; }
-    constexpr double  z() const { return z_; }
+    // True if no char of [s, s + n) has its high bit set
+    inline bool all_ascii(const char* s, size_t n)
+    {
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        for (; i + 16 <= n; i += 16)
+            if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i))) != 0)
+                return false;
+#else
+        for (; i + 8 <= n; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, s + i, sizeof(word));
+            if (word & 0x8080808080808080ull)
+                return false;
+        }
+#endif
+        for (; i < n; ++i)
+            if (static_cast<unsigned char>(s[i]) & 0x80)
+                return false;
+        return true;
+    }
 
-    friend point3d operator+(const point3d& a, const point3d& b) { return point3d(a.x() + b.x(), a.y() + b.y(), a.z() + b.z()); }
-    friend point3d operator-(const point3d& a, const point3d& b) { return point3d(a.x() - b.x(), a.y() - b.y(), a.z() - b.z()); }
-    friend point3d operator*(const point3d& a, const double k)   { return point3d(a.x() * k, a.y() * k, a.z() * k); }
-    friend bool   operator==(const point3d& a, const point3d& b) { return a.x() == b.x() && a.y() == b.y() && a.z() == b.z(); }
-    friend bool   operator!=(const point3d& a, const point3d& b) { return !(a == b); }
+#if !ZEN_HAS_SSE2
+    // SWAR range check on 8 ASCII bytes at once: bit 7 of each result byte is set
+    // iff lo <= byte <= hi. Bytes must be < 0x80 so that the additions never carry.
+    inline std::uint64_t in_range_swar(std::uint64_t word, char lo, char hi)
+    {
+        constexpr std::uint64_t ones = 0x0101010101010101ull;
+        const std::uint64_t ge_lo = word + ones * static_cast<std::uint64_t>(0x80 - lo);
+        const std::uint64_t gt_hi = word + ones * static_cast<std::uint64_t>(0x80 - hi - 1);
+        return ge_lo & ~gt_hi & (ones * 0x80);
+    }
+#endif
 
-    friend point3d operator/(const point3d& a, double k) {
-        if (k != 0) {
-            return point3d(a.x() / k, a.y() / k, a.z() / k);
+    // Flips the case of every ASCII letter in [s, s + n) that belongs to 'cls' (cc_lower,
+    // cc_upper or both) by toggling bit 0x20. Blocks holding any byte >= 0x80 are handed
+    // char by char to 'scalar', which keeps the locale-aware behavior for non-ASCII text.
+    template<class Scalar>
+    void flip_case(char* s, size_t n, unsigned char cls, Scalar scalar)
+    {
+        size_t i = 0;
+#if ZEN_HAS_SSE2
+        for (; i + 16 <= n; i += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            if (_mm_movemask_epi8(v) != 0) {
+                for (size_t j = i; j < i + 16; ++j)
+                    scalar(s[j]);
+                continue;
+            }
+            const __m128i flip = _mm_and_si128(class_mask(v, cls), _mm_set1_epi8(0x20));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(s + i), _mm_xor_si128(v, flip));
         }
-        else {
-            throw std::invalid_argument("ATTEMPTED DIVISION BY ZERO FOR point3d");
+#else
+        for (; i + 8 <= n; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, s + i, sizeof(word));
+            if (word & 0x8080808080808080ull) {
+                for (size_t j = i; j < i + 8; ++j)
+                    scalar(s[j]);
+                continue;
+            }
+            std::uint64_t mask = 0;
+            if (cls & cc_lower) mask |= in_range_swar(word, 'a', 'z');
+            if (cls & cc_upper) mask |= in_range_swar(word, 'A', 'Z');
+            word ^= mask >> 2; // 0x80 >> 2 == 0x20
+            std::memcpy(s + i, &word, sizeof(word));
+        }
+#endif
+        for (; i < n; ++i) {
+            if (static_cast<unsigned char>(s[i]) & 0x80)
+                scalar(s[i]);
+            else if (is_class(s[i], cls))
+                s[i] ^= 0x20;
         }
     }
 
-private:
-    double z_;
-};
+    // Aho-Corasick automaton over bytes with a dense transition table, so that any
+    // number of needles is found in a single left-to-right scan of the text.
+    class aho_corasick {
+    public:
+        explicit aho_corasick(const std::vector<std::string_view>& needles)
+        {
+            add_state(0);
+            for (size_t n = 0; n < needles.size(); ++n) {
+                const std::string_view needle = needles[n];
+                if (needle.empty())
+                    continue; // an empty needle would match everywhere
+
+                int32_t s = 0;
+                for (const char c : needle) {
+                    int32_t& next = go_[s][static_cast<unsigned char>(c)];
+                    if (next == 0) {
+                        next = static_cast<int32_t>(depth_.size());
+                        add_state(depth_[s] + 1);
+                    }
+                    s = next;
+                }
+                if (out_len_[s] == 0) { // the first of duplicate needles wins
+                    out_len_[s] = static_cast<int32_t>(needle.size());
+                    out_idx_[s] = static_cast<int32_t>(n);
+                }
+            }
 
-// ------------------------------------------------------------------------------------------ aliases
+            // A match in a state without children can't be extended into a longer one
+            leaf_.assign(depth_.size(), 1);
+            for (size_t st = 0; st < depth_.size(); ++st)
+                for (const int32_t next : go_[st])
+                    if (next != 0)
+                        leaf_[st] = 0;
+
+            // Breadth-first: fill the missing transitions from the failure links, and let each
+            // state inherit the longest needle that is a suffix of it if it isn't a needle itself
+            std::vector<int32_t> fail(depth_.size(), 0);
+            std::queue<int32_t> pending;
+            for (int32_t& next : go_[0])
+                if (next != 0)
+                    pending.push(next);
+
+            while (!pending.empty()) {
+                const int32_t s = pending.front();
+                pending.pop();
+                if (out_len_[s] == 0) {
+                    out_len_[s] = out_len_[fail[s]];
+                    out_idx_[s] = out_idx_[fail[s]];
+                }
+                for (int c = 0; c < 256; ++c) {
+                    int32_t& next = go_[s][c];
+                    if (next != 0) {
+                        fail[next] = go_[fail[s]][c];
+                        pending.push(next);
+                    } else {
+                        next = go_[fail[s]][c];
+                    }
+                }
+            }
+        }
 
-using point = point2d;
+        // Calls on_match(position, needle_index) for each leftmost-longest, non-overlapping match.
+        // A candidate is committed as soon as the automaton depth shows that no other match can
+        // start at or before it; scanning then resumes right after it, so each char is visited
+        // at most a needle length's worth of extra times.
+        template<class OnMatch>
+        void for_each_match(const std::string_view text, OnMatch on_match) const
+        {
+            const size_t none = std::string_view::npos;
+            size_t best_pos = none, best_len = 0, best_idx = 0;
+            size_t i = 0;
+            int32_t s = 0;
+
+            for (;;) {
+                if (i < text.size()) {
+                    s = go_[s][static_cast<unsigned char>(text[i++])];
+
+                    if (const size_t len = out_len_[s]; len != 0) {
+                        const size_t pos = i - len;
+                        if (best_pos == none || pos < best_pos || (pos == best_pos && len > best_len)) {
+                            best_pos = pos;
+                            best_len = len;
+                            best_idx = out_idx_[s];
+                        }
+                    }
+
+                    const bool final = leaf_[s] && best_pos + best_len == i;
+                    if (best_pos == none || (i - depth_[s] <= best_pos && !final))
+                        continue;
+                } else if (best_pos == none) {
+                    break;
+                }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::queue
+                on_match(best_pos, best_idx);
+                i = best_pos + best_len;
+                s = 0;
+                best_pos = none;
+            }
+        }
 
-template<class T, class C = std::deque<T>>
-class queue : public std::queue<T, C>, private zen::stackonly
-{
-public:
-    using std::queue<T, C>::queue; // inherit constructors, has to be explicit
+    private:
+        void add_state(int32_t depth)
+        {
+            go_.emplace_back();
+            go_.back().fill(0);
+            depth_.push_back(depth);
+            out_len_.push_back(0);
+            out_idx_.push_back(0);
+        }
 
-    queue(const std::queue<T, C>& q) : std::queue<T, C>(q) {}
-    
-    template<class Iterable>
-    queue(const Iterable& c)
-    {
-        ZEN_STATIC_ASSERT(zen::is_iterable_v<Iterable>, "TEMPLATE PARAMETER EXPECTED TO BE Iterable, BUT IS NOT");
+        std::vector<std::array<int32_t, 256>> go_;      // transitions, 0 is the root
+        std::vector<int32_t>                  depth_;   // length of the prefix each state spells
+        std::vector<int32_t>                  out_len_; // longest needle ending in this state, 0 if none
+        std::vector<int32_t>                  out_idx_; // index of that needle
+        std::vector<char>                     leaf_;    // 1 if the state has no children in the trie
+    };
 
-        for (const auto& x : c)
-            my::push(x);
-    }
+    // Hand-written scanners for the fixed extract_* patterns. Each one returns the same match
+    // as std::regex_search() with the pattern in its comment (leftmost start, then the first
+    // alternative the backtracking engine would accept), or an empty view if there is none.
+    inline bool is_word(char c) { return c == '_' || is_class(c, cc_alnum); }
 
-    bool is_empty() const { return my::empty(); }
+    inline bool is_word_at(const std::string_view s, size_t i) { return i < s.size() && is_word(s[i]); }
 
-private:
-    using my = queue<T, C>;
-};
+    // End of the run of chars satisfying 'pred' that starts at 'i'
+    template<class Pred>
+    size_t skip_while(const std::string_view s, size_t i, Pred pred)
+    {
+        while (i < s.size() && pred(s[i]))
+            ++i;
+        return i;
+    }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::priority_queue
+    inline bool is_digit(char c) { return is_class(c, cc_digit); }
 
-template<
-    class T,
-    class C = std::vector<T>,
-    class L = std::less<typename C::value_type>
->
-class priority_queue : public std::priority_queue<T, C, L>, private zen::stackonly
-{
-public:
-    using std::priority_queue<T, C, L>::priority_queue; // inherit constructors, has to be explicit
+    // (\d+)\.(\d+)\.(\d+)\.(\d+) and (\d+\/\d+\/\d+): '.' and '/' are never digits, so each
+    // \d+ takes its whole run and only the first digit of a run can start a match
+    inline std::string_view scan_digit_groups(const std::string_view s, char separator, int groups)
+    {
+        for (size_t first = 0; first < s.size(); ++first) {
+            if (!is_digit(s[first]) || (first > 0 && is_digit(s[first - 1])))
+                continue;
+
+            size_t i = skip_while(s, first, is_digit);
+            int matched = 1;
+            while (matched < groups && i + 1 < s.size() && s[i] == separator && is_digit(s[i + 1])) {
+                i = skip_while(s, i + 1, is_digit);
+                ++matched;
+            }
+            if (matched == groups)
+                return s.substr(first, i - first);
+            first = i - 1; // no match can start inside this run
+        }
+        return {};
+    }
 
-    priority_queue(const std::priority_queue<T, C, L>& q) : std::priority_queue<T, C, L>(q) {}
+    inline std::string_view scan_version(const std::string_view s) { return scan_digit_groups(s, '.', 4); }
+    inline std::string_view scan_date   (const std::string_view s) { return scan_digit_groups(s, '/', 3); }
 
-    template<class Iterable>
-    priority_queue(const Iterable& c)
+    // \b[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,}\b
+    inline std::string_view scan_email(const std::string_view s)
     {
-        ZEN_STATIC_ASSERT(zen::is_iterable_v<Iterable>, "TEMPLATE PARAMETER EXPECTED TO BE Iterable, BUT IS NOT");
-
-        for (const auto& x : c)
-            my::push(x);
+        const auto is_local  = [](char c) { return is_class(c, cc_alnum) || c == '.' || c == '_' || c == '%' || c == '+' || c == '-'; };
+        const auto is_domain = [](char c) { return is_class(c, cc_alnum) || c == '.' || c == '-'; };
+        const auto is_alpha  = [](char c) { return is_class(c, cc_alpha); };
+
+        // '@' is in neither class, so every match contains exactly one '@', and the matches
+        // around an earlier '@' always start before those around a later one
+        for (size_t at = s.find('@'); at != std::string_view::npos; at = s.find('@', at + 1)) {
+            // The domain doesn't depend on where the match starts: the greedy domain run gives
+            // back chars until a '.' followed by 2+ letters and a word boundary
+            const size_t domain_end = skip_while(s, at + 1, is_domain);
+            size_t match_end = 0;
+            for (size_t dot = domain_end; dot-- > at + 2; ) {
+                if (s[dot] != '.')
+                    continue;
+                const size_t letters_end = skip_while(s, dot + 1, is_alpha);
+                if (letters_end - dot > 2 && !is_word_at(s, letters_end)) {
+                    match_end = letters_end;
+                    break;
+                }
+            }
+            if (match_end == 0)
+                continue;
+
+            // Leftmost start within the local-part run before '@' that sits on a word boundary
+            size_t run = at;
+            while (run > 0 && is_local(s[run - 1]))
+                --run;
+            for (size_t first = run; first < at; ++first)
+                if ((first > 0 && is_word(s[first - 1])) != is_word(s[first]))
+                    return s.substr(first, match_end - first);
+        }
+        return {};
     }
 
-    bool is_empty() const { return my::empty(); }
+    // https?://[^\s]+
+    inline std::string_view scan_url(const std::string_view s)
+    {
+        for (size_t first = s.find("http"); first != std::string_view::npos; first = s.find("http", first + 1)) {
+            size_t i = first + 4;
+            if (i < s.size() && s[i] == 's')
+                ++i;
+            if (s.substr(i, 3) != "://")
+                continue;
+            const size_t last = skip_while(s, i + 3, [](char c) { return !is_class(c, cc_space); });
+            if (last > i + 3)
+                return s.substr(first, last - first);
+        }
+        return {};
+    }
 
-private:
-    using my = priority_queue<T, C, L>;
-};
+    // #\w+
+    inline std::string_view scan_hashtag(const std::string_view s)
+    {
+        for (size_t first = s.find('#'); first != std::string_view::npos; first = s.find('#', first + 1))
+            if (is_word_at(s, first + 1))
+                return s.substr(first, skip_while(s, first + 1, is_word) - first);
+        return {};
+    }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::set
+    // \.\w+$ ('$' being the end of the text): '.' is not a word char, so only the last one can match
+    inline std::string_view scan_extension(const std::string_view s)
+    {
+        const size_t dot = s.rfind('.');
+        if (dot == std::string_view::npos || dot + 1 == s.size() || skip_while(s, dot + 1, is_word) != s.size())
+            return {};
+        return s.substr(dot);
+    }
+} // namespace internal
 
-template<class K, class C = std::less<K>, class A = std::allocator<K>>
-class set : public std::set<K, C, A>, private zen::stackonly
-{
+// A lazy, allocation-free range of the tokens of a text between separators, as
+// std::string_views into the text (which therefore has to outlive the range).
+// Example: for (std::string_view field : zen::split_range(line, ","))
+// Single-char separators are searched with memchr(), which standard libraries vectorize.
+class split_range {
 public:
-    using std::set<K, C, A>::set; // inherit constructors, has to be explicit
+    // With drop_trailing_empty, a text ending in a separator doesn't produce a last
+    // empty token, which is how std::getline() treats a final '\n'
+    split_range(const std::string_view text, const std::string_view separator, bool drop_trailing_empty = false)
+        : text_(text), separator_(separator), drop_trailing_empty_(drop_trailing_empty)
+    {
+        if (separator.empty())
+            throw std::invalid_argument("STRING SEPARATOR CANNOT BE EMPTY");
+    }
 
-    set(const std::set<K, C, A>& u) : std::set<K, C, A>(u) {}
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::string_view;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const std::string_view*;
+        using reference         = const std::string_view&;
 
-    template<class Kx, class Cx, class Ax>
-    set(const std::set<Kx, Cx, Ax>& u) : std::set<K, C, A>(u.begin(), u.end()) {}
+        iterator() = default;
 
-    bool is_empty() const { return my::empty(); }
+        iterator(const split_range* range, const char* pos) : range_(range)
+        {
+            if (pos)
+                find_token(pos);
+        }
 
-private:
-    using my = set<K, C, A>;
-};
+        reference operator*()  const { return token_; }
+        pointer   operator->() const { return &token_; }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::multiset
+        iterator& operator++()
+        {
+            const char* next = token_.data() + token_.size();
+            if (next == range_->end_of_text()) {
+                range_ = nullptr; // that was the last token
+                token_ = {};
+            } else {
+                find_token(next + range_->separator_.size());
+            }
+            return *this;
+        }
 
-template<class K, class C = std::less<K>, class A = std::allocator<K>>
-class multiset : public std::multiset<K, C, A>, private zen::stackonly
-{
-public:
-    using std::multiset<K, C, A>::multiset; // inherit constructors, has to be explicit
+        iterator operator++(int) { iterator old = *this; ++*this; return old; }
 
-    multiset(const std::multiset<K, C, A>& u) : std::multiset<K, C, A>(u) {}
+        friend bool operator==(const iterator& a, const iterator& b)
+        {
+            return a.range_ == b.range_ && a.token_.data() == b.token_.data();
+        }
+        friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
 
-    template<class Kx, class Cx, class Ax>
-    multiset(const std::multiset<Kx, Cx, Ax>& u) : std::multiset<K, C, A>(u.begin(), u.end()) {}
+    private:
+        void find_token(const char* first)
+        {
+            const char* last = range_->end_of_text();
+            if (first == last && range_->drop_trailing_empty_ && first != range_->text_.data()) {
+                range_ = nullptr;
+                token_ = {};
+                return;
+            }
+            token_ = std::string_view(first, static_cast<size_t>(range_->find_separator(first) - first));
+        }
 
-    bool is_empty() const { return my::empty(); }
+        const split_range* range_ = nullptr; // nullptr once past the last token
+        std::string_view   token_;
+    };
 
-private:
-    using my = multiset<K, C, A>;
-};
+    iterator begin() const
+    {
+        if (text_.empty() && drop_trailing_empty_)
+            return end();
+        return iterator(this, text_.data());
+    }
+    iterator end() const { return iterator(); }
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::stack
+    // Materializes the tokens, still without copying any characters
+    std::vector<std::string_view> to_vector() const { return std::vector<std::string_view>(begin(), end()); }
 
-template<class T, class C = std::deque<T>>
-class stack : public std::stack<T, C>, private zen::stackonly
-{
-public:
-    using std::stack<T, C>::stack; // inherit constructors, has to be explicit
+private:
+    const char* end_of_text() const { return text_.data() + text_.size(); }
 
-    stack(const std::stack<T, C>& q) : std::stack<T, C>(q) {}
-        
-    bool is_empty() const { return my::empty(); }
+    // Returns the start of the next separator at or after 'first', or the end of the text
+    const char* find_separator(const char* first) const
+    {
+        const char* last = end_of_text();
+        const char  lead = separator_.front();
+        while (first != last) {
+            const void* hit = std::memchr(first, lead, static_cast<size_t>(last - first));
+            if (!hit)
+                return last;
+            const char* p = static_cast<const char*>(hit);
+            if (static_cast<size_t>(last - p) < separator_.size())
+                return last;
+            if (separator_.size() == 1 || std::memcmp(p, separator_.data(), separator_.size()) == 0)
+                return p;
+            first = p + 1;
+        }
+        return last;
+    }
 
-private:
-    using my = stack<T, C>;
+    std::string_view text_;
+    std::string_view separator_;
+    bool             drop_trailing_empty_;
 };
 
-///////////////////////////////////////////////////////////////////////////////////////////// zen::string
-
 class string : public std::string, private zen::stackonly
 {
 public:
@@ -1227,35 +4539,52 @@ public:
         return substr(posBeg + 1, posEnd - posBeg - 1);
     }
 
-    zen::string extract_pattern(const std::string& pattern)
+    zen::string extract_pattern(const std::string& pattern) const
     {
-        const std::regex regex_pattern(pattern);
-        std::smatch match;
-        std::string in(my::begin(), my::end());
+        return extract_pattern(internal::cached_regex(pattern));
+    }
+
+    // Searches the characters in place, without copying the string first
+    zen::string extract_pattern(const std::regex& regex_pattern) const
+    {
+        std::cmatch match;
 
-        if (std::regex_search(in,   match, regex_pattern)) {
+        if (std::regex_search(my::data(), my::data() + my::size(), match, regex_pattern)) {
             const size_t startPos = match.position(0);
             const size_t length   = match.length(0);
 
-            // Create a sub-string_view using the position and length
             return std::string(my::data() + startPos, length);
         }
 
         return ""; // signals 'no match'
     }
 
+#if ZEN_HAS_CT_REGEX
+    // Example: s.extract_pattern<R"(\d+/\d+/\d+)">();
+    // The pattern is compiled at compile time (see zen::ct_regex), and the leftmost-longest match is returned
+    template<fixed_string Pattern>
+    zen::string extract_pattern() const
+    {
+        if (const auto match = ct_regex<Pattern>::search(*this))
+            return *match;
+
+        return ""; // signals 'no match'
+    }
+#endif
+
     zen::string& remove(const std::string& pattern)
     {
-        *this = std::regex_replace(*this, std::regex(pattern), std::string(""));
+        *this = std::regex_replace(*this, internal::cached_regex(pattern), std::string(""));
         return *this; // for natural chaining
     }
 
-    auto extract_version()   { return extract_pattern(R"((\d+)\.(\d+)\.(\d+)\.(\d+))"                          ); } // Like "X.Y.Z.B"
-    auto extract_date()      { return extract_pattern(R"((\d+\/\d+\/\d+))"                                     ); } // Like "31/12/2021"
-    auto extract_email()     { return extract_pattern(R"((\b[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,}\b))"); }
-    auto extract_url()       { return extract_pattern(R"((https?://[^\s]+))"                                   ); }
-    auto extract_hashtag()   { return extract_pattern(R"((#\w+))"                                              ); } // Like "#event"
-    auto extract_extension() { return extract_pattern(R"((\.\w+$))"                                            ); }
+    // The fixed patterns are matched by hand-written scanners with the same results as these regexes
+    zen::string extract_version()   const { return internal::scan_version  (*this); } // Like "X.Y.Z.B", (\d+)\.(\d+)\.(\d+)\.(\d+)
+    zen::string extract_date()      const { return internal::scan_date     (*this); } // Like "31/12/2021", (\d+\/\d+\/\d+)
+    zen::string extract_email()     const { return internal::scan_email    (*this); } // \b[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,}\b
+    zen::string extract_url()       const { return internal::scan_url      (*this); } // https?://[^\s]+
+    zen::string extract_hashtag()   const { return internal::scan_hashtag  (*this); } // Like "#event", #\w+
+    zen::string extract_extension() const { return internal::scan_extension(*this); } // \.\w+$
 
     // Modifying functions
     auto& prefix(const std::string_view s)
@@ -1295,14 +4624,32 @@ public:
     {
         if (search.empty()) return *this;
 
-        size_t pos = 0;
-        while ((pos = my::find(search, pos)) != std::string::npos) {
-            std::string::replace(pos, search.length(), replacement);
-            pos += replacement.length(); // move pos forward by the length of replace to prevent infinite loops
+        // Replacing in place shifts the whole tail on every match, which goes quadratic
+        // with many hits. Instead, count the matches first, then build the result in one
+        // allocation.
+        size_t matches = 0;
+        for (size_t pos = my::find(search); pos != std::string::npos; pos = my::find(search, pos + search.length()))
+            ++matches;
+
+        if (matches == 0) return *this;
+
+        std::string result;
+        result.reserve(my::size() - matches * search.length() + matches * replacement.length());
+
+        size_t done = 0;
+        for (size_t pos = my::find(search); pos != std::string::npos; pos = my::find(search, pos + search.length())) {
+            result.append(my::data() + done, pos - done);
+            result += replacement;
+            done = pos + search.length();
         }
+        result.append(my::data() + done, my::size() - done);
+
+        std::string::operator=(std::move(result));
         return *this;
     }
 
+    // Unlike replacing in place, the predicate is shown the original string for every
+    // match, so its answer doesn't depend on the replacements made before it.
     template <typename Pred>
     auto& replace_all_if(const std::string& search, const std::string& replacement, Pred predicate)
     {
@@ -1313,15 +4660,68 @@ public:
         static_assert(std::is_same_v<std::invoke_result_t<Pred, const std::string&>, bool>,
             "TEMPLATE PARAMETER Pred MUST RETURN bool, BUT DOES NOT");
 
-        size_t pos = 0;
-        while ((pos = my::find(search, pos)) != std::string::npos) {
+        // The predicate is called exactly once per match, so count all matches
+        // to reserve for the worst case instead of asking it twice
+        size_t matches = 0;
+        for (size_t pos = my::find(search); pos != std::string::npos; pos = my::find(search, pos + search.length()))
+            ++matches;
+
+        if (matches == 0) return *this;
+
+        std::string result;
+        result.reserve(my::size() + (replacement.length() > search.length() ? matches * (replacement.length() - search.length()) : 0));
+
+        size_t done = 0;
+        for (size_t pos = my::find(search); pos != std::string::npos; pos = my::find(search, pos + search.length())) {
             if (predicate(*this)) {
-                std::string::replace(pos, search.length(), replacement);
-                pos += replacement.length(); // move pos forward by the length of replace to prevent infinite loops
-            } else {
-                pos += search.length(); // move pos forward by the length of search
+                result.append(my::data() + done, pos - done);
+                result += replacement;
+                done = pos + search.length();
             }
         }
+        result.append(my::data() + done, my::size() - done);
+
+        std::string::operator=(std::move(result));
+        return *this;
+    }
+
+    // Replaces many needles in a single scan, for example:
+    // s.replace_all({ { "&", "&amp;" }, { "<", "&lt;" }, { ">", "&gt;" } });
+    // Where needles compete, the leftmost match wins, then the longest one; matches
+    // never overlap and replaced text is not searched again.
+    auto& replace_all(const std::vector<std::pair<std::string, std::string>>& replacements)
+    {
+        std::vector<std::string_view> needles;
+        needles.reserve(replacements.size());
+        for (const auto& r : replacements)
+            needles.emplace_back(r.first);
+
+        const internal::aho_corasick automaton(needles);
+        const std::string_view text(my::data(), my::size());
+
+        // One scan records the matches, so the result can be sized and built in one allocation
+        std::vector<std::pair<size_t, size_t>> matches; // position, replacement index
+        size_t length = text.size();
+        automaton.for_each_match(text, [&](size_t pos, size_t idx) {
+            matches.emplace_back(pos, idx);
+            length += replacements[idx].second.length();
+            length -= replacements[idx].first.length();
+        });
+
+        if (matches.empty()) return *this;
+
+        std::string result;
+        result.reserve(length);
+
+        size_t done = 0;
+        for (const auto& [pos, idx] : matches) {
+            result.append(text.data() + done, pos - done);
+            result += replacements[idx].second;
+            done = pos + replacements[idx].first.length();
+        }
+        result.append(text.data() + done, text.size() - done);
+
+        std::string::operator=(std::move(result));
         return *this;
     }
 
@@ -1334,7 +4734,8 @@ public:
     auto& trim()
     {
         // Trim leading and trailing spaces
-        my::assign(std::regex_replace(*this, std::regex("^\\s+|\\s+$"), std::string("")));
+        static const std::regex rx_outer_spaces("^\\s+|\\s+$");
+        my::assign(std::regex_replace(*this, rx_outer_spaces, std::string("")));
         return *this; // for natural chaining
     }
 
@@ -1346,7 +4747,8 @@ public:
     auto& deflate()
     {
         // Replace any & all multiple spaces with a single space
-        my::assign(std::regex_replace(my::trim(), std::regex("\\s+"), " "));
+        static const std::regex rx_spaces("\\s+");
+        my::assign(std::regex_replace(my::trim(), rx_spaces, " "));
         return *this; // for natural chaining
     }
 
@@ -1420,31 +4822,18 @@ public:
             my::front() = static_cast<char>(std::toupper(my::front())); // capitalize the first character
         }
 
-        for (size_t i = 1; i < my::size(); ++i) {
-            char& c = my::at(i);
-            if (std::isalpha(c) && std::isupper(c)) {
-                c = static_cast<char>(std::tolower(c));
-            }
-        }
+        internal::flip_case(my::data() + 1, my::size() - 1, internal::cc_upper, lower_char);
 
         return *this;
     }
 
     auto& to_lower() {
-        for (auto& c : *this) {
-            if (std::isalpha(c) && std::isupper(c)) {
-                c = static_cast<char>(std::tolower(c));
-            }
-        }
+        internal::flip_case(my::data(), my::size(), internal::cc_upper, lower_char);
         return *this;
     }
 
     auto& to_upper() {
-        for (auto& c : *this) {
-            if (std::isalpha(c) && std::islower(c)) {
-                c = static_cast<char>(std::toupper(c));
-            }
-        }
+        internal::flip_case(my::data(), my::size(), internal::cc_lower, upper_char);
         return *this;
     }
 
@@ -1461,25 +4850,25 @@ public:
         return *this;
     }
 
-    bool is_printable() const { return                std::all_of(my::begin(), my::end(), [](auto c) { return std::isprint(c); }); }
-    bool is_alnum()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::isalnum(c); }); }
-    bool is_alpha()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::isalpha(c); }); }
-    bool is_digit()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::isdigit(c); }); }
-    bool is_lower()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::islower(c); }); }
-    bool is_upper()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::isupper(c); }); }
-    bool is_space()     const { return !is_empty() && std::all_of(my::begin(), my::end(), [](auto c) { return std::isspace(c); }); }
+    bool is_printable() const { return                internal::all_of_class(my::data(), my::size(), internal::cc_print); }
+    bool is_alnum()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_alnum); }
+    bool is_alpha()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_alpha); }
+    bool is_digit()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_digit); }
+    bool is_lower()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_lower); }
+    bool is_upper()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_upper); }
+    bool is_space()     const { return !is_empty() && internal::all_of_class(my::data(), my::size(), internal::cc_space); }
 
     bool is_identifier() const
     {
         if (is_empty())
             return false;
 
-        if (!std::isalpha(front()) && front() != '_')
+        if (!internal::is_class(front(), internal::cc_alpha) && front() != '_')
             return false;
 
         for (size_t i = 1; i < my::size(); ++i) {
             const char& c = my::at(i);
-            if (!std::isalnum(c) && c != '_') {
+            if (!internal::is_class(c, internal::cc_alnum) && c != '_') {
                 return false;
             }
         }
@@ -1573,59 +4962,61 @@ public:
         return std::make_tuple(before, sep, after);
     }
 
-    std::vector<zen::string> split(const std::string& separator)
+    std::vector<zen::string> split(const std::string& separator) const
     {
         // TODO: Can be template to support any container
         std::vector<zen::string> result;
-        std::string s(*this);
-        std::string token;
-        size_t pos = 0;
-        while ((pos = s.find(separator)) != std::string::npos) {
-            token = s.substr(0, pos);
-            result.push_back(token);
-            s.erase(0, pos + separator.length());
-        }
-        result.push_back(s);
+        for (const std::string_view token : split_view(separator))
+            result.emplace_back(token);
         return result;
     }
 
-    std::vector<zen::string> split_lines()
+    std::vector<zen::string> split_lines() const
     {
         std::vector<zen::string> lines;
-        std::istringstream f(*this);
-        std::string line;
-        while (std::getline(f, line)) {
-            lines.push_back(line);
-        }
+        lines.reserve(static_cast<size_t>(std::count(my::begin(), my::end(), '\n')) + 1);
+        for (const std::string_view line : split_lines_view())
+            lines.emplace_back(line);
         return lines;
     }
 
-    auto& swapcase()
+    // Allocation-free versions of split() and split_lines(): the tokens are
+    // std::string_views into this string, produced lazily while iterating.
+    // Example: for (std::string_view line : log.split_lines_view())
+    zen::split_range split_view(const std::string_view separator) const
     {
-        for (auto& c : *this) {
-            if (std::isalpha(c)) {
-                c = std::islower(c) ? static_cast<char>(std::toupper(c)) : static_cast<char>(std::tolower(c));
-            }
-        }
-        return *this;
+        return zen::split_range(std::string_view(my::data(), my::size()), separator);
+    }
+
+    zen::split_range split_lines_view() const
+    {
+        return zen::split_range(std::string_view(my::data(), my::size()), "\n", true);
     }
 
-    bool is_ascii()
+    auto& swapcase()
     {
-        for (char c : *this)
-            if (!isascii(c))
-                return false;
-        return true;
+        internal::flip_case(my::data(), my::size(), internal::cc_lower | internal::cc_upper, swap_char);
+        return *this;
     }
 
-private:
-    using my = zen::string;
-};
+    bool is_ascii() const { return internal::all_ascii(my::data(), my::size()); }
 
-struct string_hash {
-    size_t operator()(const zen::string& z) const {
-        return std::hash<std::string>()(z);
+private:
+    // Scalar, locale-aware conversions used for chars that the ASCII fast paths don't handle
+    static void lower_char(char& c) {
+        if (std::isalpha(c) && std::isupper(c))
+            c = static_cast<char>(std::tolower(c));
+    }
+    static void upper_char(char& c) {
+        if (std::isalpha(c) && std::islower(c))
+            c = static_cast<char>(std::toupper(c));
     }
+    static void swap_char(char& c) {
+        if (std::isalpha(c))
+            c = std::islower(c) ? static_cast<char>(std::toupper(c)) : static_cast<char>(std::tolower(c));
+    }
+
+    using my = zen::string;
 };
 
 template <class Rep, class Period>
@@ -1700,8 +5091,8 @@ auto measure_execution(std::function<void()> operation)
 template<
     class K,
     class V,
-    class H = std::hash<K>,
-    class E = std::equal_to<K>,
+    class H = internal::default_hash<K>,
+    class E = internal::default_equal<K>,
     class A = std::allocator<std::pair<const K, V>>
 >
 class unordered_map : public std::unordered_map<K, V, H, E, A>, private zen::stackonly
@@ -1716,6 +5107,10 @@ public:
     unordered_map(const std::unordered_map<Kx, Vx, Hx, Ex, Ax>& u)
         : std::unordered_map<K, V, H, E, A>(u.begin(), u.end()) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::unordered_map<K, V, H, E, A>>
+    explicit unordered_map(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
@@ -1727,8 +5122,8 @@ private:
 template<
     class K,
     class V,
-    class H = std::hash<K>,
-    class E = std::equal_to<K>,
+    class H = internal::default_hash<K>,
+    class E = internal::default_equal<K>,
     class A = std::allocator<std::pair<const K, V>>
 >
 class unordered_multimap : public std::unordered_multimap<K, V, H, E, A>, private zen::stackonly
@@ -1743,6 +5138,10 @@ public:
     unordered_multimap(const std::unordered_multimap<Kx, Vx, Hx, Ex, Ax>& u)
         : std::unordered_multimap<K, V, H, E, A>(u.begin(), u.end()) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::unordered_multimap<K, V, H, E, A>>
+    explicit unordered_multimap(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
@@ -1753,8 +5152,8 @@ private:
 
 template<
     class T,
-    class H = std::hash<T>,
-    class E = std::equal_to<T>,
+    class H = internal::default_hash<T>,
+    class E = internal::default_equal<T>,
     class A = std::allocator<T>
 >
 class unordered_set : public std::unordered_set<T, H, E, A>, private zen::stackonly
@@ -1769,6 +5168,10 @@ public:
     unordered_set(const std::unordered_set<Tx, Hx, Ex, Ax>& u)
         : std::unordered_set<T, H, E, A>(u.begin(), u.end()) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::unordered_set<T, H, E, A>>
+    explicit unordered_set(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
@@ -1779,8 +5182,8 @@ private:
 
 template<
     class T,
-    class H = std::hash<T>,
-    class E = std::equal_to<T>,
+    class H = internal::default_hash<T>,
+    class E = internal::default_equal<T>,
     class A = std::allocator<T>
 >
 class unordered_multiset : public std::unordered_multiset<T, H, E, A>, private zen::stackonly
@@ -1795,6 +5198,10 @@ public:
     unordered_multiset(const std::unordered_multiset<Tx, Hx, Ex, Ax>& u)
         : std::unordered_multiset<T, H, E, A>(u.begin(), u.end()) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::unordered_multiset<T, H, E, A>>
+    explicit unordered_multiset(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     bool is_empty() const { return my::empty(); }
 
 private:
@@ -1811,6 +5218,10 @@ public:
 
     vector(const std::vector<T, A>& v) : std::vector<T, A>(v) {}
 
+    // Builds from any iterable in one go, reserving and moving where it can (see zen::ingest)
+    template<class Iterable> requires internal::ingestible<Iterable, std::vector<T, A>>
+    explicit vector(Iterable&& c) { zen::ingest(*this, std::forward<Iterable>(c)); }
+
     template<class Pred>
     typename std::enable_if<std::is_invocable_r<bool, Pred, const T&>::value, bool>::type
         contains(Pred p) const
@@ -1818,7 +5229,7 @@ public:
         return std::find_if(my::begin(), my::end(), p) != my::end();
     }
 
-    bool contains(const T& x) const { return std::find(my::begin(), my::end(), x) != my::end(); }
+    bool contains(const T& x) const { return internal::find_value(my::begin(), my::end(), x) != my::end(); }
     
     bool is_empty() const { return my::empty(); }
 
@@ -1848,15 +5259,12 @@ public:
         : std::array<int, 4>{major, minor, patch, build}
     {}
 
-    explicit version(const std::string& text)
+    explicit version(const std::string_view text)
     {
-        static const std::regex rx_version{R"((\d+)\.(\d+)\.(\d+)\.(\d+))"};
-        if (std::smatch sm; std::regex_match(text, sm, rx_version)) {
-            at(0) = std::stoi(sm[1]);
-            at(1) = std::stoi(sm[2]);
-            at(2) = std::stoi(sm[3]);
-            at(3) = std::stoi(sm[4]);
-        } else {
+        const std::errc ec = parse(text, *this);
+        if (ec == std::errc::result_out_of_range)
+            throw std::out_of_range(std::string(typeid(*this).name()) + " CONSTRUCTOR ARGUMENT NUMBER DOESN'T FIT IN AN INT.");
+        if (ec != std::errc{}) {
             throw std::invalid_argument{
                 // Any cost of typeid is likely to be dwarfed by the cost of the exception anyway
                 std::string(typeid(*this).name()) + " CONSTRUCTOR ARGUMENT STRING DOESN'T MATCH THE EXPECTED M.M.P.B PATTERN."
@@ -1864,15 +5272,71 @@ public:
         }
     }
 
+    // Parses "M.M.P.B" in a single pass with std::from_chars, without allocating or throwing.
+    // Returns std::nullopt if the text doesn't match (\d+)\.(\d+)\.(\d+)\.(\d+) or a number overflows.
+    static std::optional<version> try_parse(const std::string_view text)
+    {
+        version v(0, 0, 0, 0);
+        if (parse(text, v) != std::errc{})
+            return std::nullopt;
+        return v;
+    }
+
+    // The longest text to_chars() can produce: four ints of up to 11 chars ("-2147483648") and three dots
+    static constexpr size_t max_chars = 4 * 11 + 3;
+
+    // Writes "M.M.P.B" to [first, last) without allocating, like std::to_chars()
+    // Example: char buf[zen::version::max_chars]; auto [end, ec] = v.to_chars(buf, buf + sizeof buf);
+    std::to_chars_result to_chars(char* first, char* last) const
+    {
+        for (size_t i = 0; i < size(); ++i) {
+            if (i != 0) {
+                if (first == last)
+                    return { last, std::errc::value_too_large };
+                *first++ = '.';
+            }
+            const auto result = std::to_chars(first, last, (*this)[i]);
+            if (result.ec != std::errc{})
+                return result;
+            first = result.ptr;
+        }
+        return { first, std::errc{} };
+    }
+
     constexpr auto major() const { return at(0); }
     constexpr auto minor() const { return at(1); }
     constexpr auto patch() const { return at(2); }
     constexpr auto build() const { return at(3); }
+
+private:
+    // Every number has to be a non-empty run of digits, so the signs from_chars() accepts are rejected up front
+    static std::errc parse(const std::string_view text, version& v)
+    {
+        const char* first = text.data();
+        const char* last  = text.data() + text.size();
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (i != 0 && (first == last || *first++ != '.'))
+                return std::errc::invalid_argument;
+            if (first == last || *first < '0' || *first > '9')
+                return std::errc::invalid_argument;
+            const auto [ptr, ec] = std::from_chars(first, last, v[i]);
+            if (ec != std::errc{})
+                return ec;
+            first = ptr;
+        }
+        return first == last ? std::errc{} : std::errc::invalid_argument;
+    }
 };
 
 std::ostream& operator<<(std::ostream& os, const version& v)
 {
-    return os << v.major() << '.' << v.minor() << '.' << v.patch() << '.' << v.build();
+    char buf[version::max_chars];
+    const auto [end, ec] = v.to_chars(buf, buf + sizeof buf);
+    if (ec != std::errc{}) {
+        os.setstate(std::ios::failbit);
+        return os;
+    }
+    return os << std::string_view(buf, static_cast<size_t>(end - buf));
 }
 
 namespace literals::version {
@@ -1885,6 +5349,163 @@ zen::version operator""_version(const char* text, size_t)
 
 } // namespace literals::version
 
+///////////////////////////////////////////////////////////////////////////////////////////// BINARY SERIALIZATION
+// Compact binary encoding of values, in the byte order and type sizes of the machine,
+// so it is meant for data read back by the same build (caches, snapshots, IPC).
+// Example: const auto bytes = zen::to_bytes(m);                 // m is a zen::map<zen::string, int>
+//          auto copy = zen::from_bytes<zen::map<zen::string, int>>(bytes);
+// Supported: arithmetic and other trivially copyable types, zen::point2d/3d, std::pair,
+// std::tuple, strings and any container with size() and insert() (vector, map, unordered_map...).
+// Containers are written as a 64-bit element count followed by the elements; contiguous
+// containers of trivially copyable elements are copied with a single memcpy().
+// Views (std::string_view, std::span...) are written as the elements they refer to and
+// read back into an owning container such as std::string or std::vector.
+
+namespace internal {
+    template<class T> struct is_tuple : std::false_type {};
+    template<class... Ts> struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+
+    template<class T>
+    concept pair_like = requires { typename T::first_type; typename T::second_type; }
+        && std::is_base_of_v<std::pair<typename T::first_type, typename T::second_type>, T>;
+
+    template<class T>
+    concept bulk_range = std::ranges::contiguous_range<T> && std::ranges::sized_range<T>
+        && std::is_trivially_copyable_v<std::ranges::range_value_t<T>>;
+
+    template<class T>
+    concept sized_container = std::ranges::sized_range<T> && requires { typename T::value_type; };
+
+    // Binary-safe counterpart of a container's value_type: std::pair<const K, V> becomes std::pair<K, V>
+    template<class T> struct readable { using type = T; };
+    template<class K, class V> struct readable<std::pair<const K, V>> { using type = std::pair<K, V>; };
+
+    // Views such as std::string_view and std::span are trivially copyable too, but their
+    // bytes are a pointer and a length: they are written as the range they refer to instead
+    template<class T>
+    constexpr bool is_raw_copyable_v = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !std::is_member_pointer_v<T>
+                                    && !std::ranges::view<T> && !std::ranges::borrowed_range<T>;
+
+    template<class> constexpr bool always_false_v = false;
+} // namespace internal
+
+class binary_writer {
+public:
+    template<class T>
+    binary_writer& write(const T& x)
+    {
+        if constexpr (std::is_same_v<T, zen::point3d>) { // before point2d, its base
+            write(x.x()).write(x.y()).write(x.z());
+        } else if constexpr (internal::pair_like<T>) {   // also zen::point2d
+            write(x.first).write(x.second);
+        } else if constexpr (internal::is_tuple<T>::value) {
+            std::apply([this](const auto&... items) { (write(items), ...); }, x);
+        } else if constexpr (internal::is_raw_copyable_v<T>) {
+            append(&x, sizeof x);
+        } else if constexpr (internal::bulk_range<T>) {
+            write_size(std::ranges::size(x));
+            append(std::ranges::data(x), std::ranges::size(x) * sizeof(std::ranges::range_value_t<T>));
+        } else if constexpr (internal::sized_container<T>) {
+            write_size(std::ranges::size(x));
+            for (const auto& item : x)
+                write(item);
+        } else {
+            static_assert(internal::always_false_v<T>, "TYPE IS NOT BINARY SERIALIZABLE");
+        }
+        return *this;
+    }
+
+    const std::vector<char>& bytes() const { return bytes_; }
+    std::vector<char>        take()        { return std::move(bytes_); }
+
+private:
+    void write_size(size_t n) { write(static_cast<uint64_t>(n)); }
+
+    void append(const void* p, size_t n)
+    {
+        const char* first = static_cast<const char*>(p);
+        bytes_.insert(bytes_.end(), first, first + n);
+    }
+
+    std::vector<char> bytes_;
+};
+
+class binary_reader {
+public:
+    binary_reader(const char* data, size_t size) : pos_(data), end_(data + size) {}
+    explicit binary_reader(const std::vector<char>& bytes) : binary_reader(bytes.data(), bytes.size()) {}
+
+    template<class T>
+    binary_reader& read(T& x)
+    {
+        if constexpr (std::is_same_v<T, zen::point3d>) {
+            read(x.x()).read(x.y()).read(x.z());
+        } else if constexpr (internal::pair_like<T>) {
+            read(x.first).read(x.second);
+        } else if constexpr (internal::is_tuple<T>::value) {
+            std::apply([this](auto&... items) { (read(items), ...); }, x);
+        } else if constexpr (internal::is_raw_copyable_v<T>) {
+            copy_out(&x, sizeof x);
+        } else if constexpr (internal::bulk_range<T> && requires { x.resize(size_t{}); }) {
+            const size_t n = read_size(sizeof(std::ranges::range_value_t<T>));
+            x.resize(n);
+            copy_out(std::ranges::data(x), n * sizeof(std::ranges::range_value_t<T>));
+        } else if constexpr (internal::sized_container<T> && requires { x.insert(x.end(), std::declval<typename T::value_type>()); }) {
+            using item_type = typename internal::readable<typename T::value_type>::type;
+            const size_t n = read_size(1);
+            x.clear();
+            if constexpr (requires { x.reserve(n); })
+                x.reserve(n);
+            for (size_t i = 0; i < n; ++i) {
+                item_type item{};
+                read(item);
+                x.insert(x.end(), std::move(item));
+            }
+        } else {
+            static_assert(internal::always_false_v<T>, "TYPE IS NOT BINARY DESERIALIZABLE");
+        }
+        return *this;
+    }
+
+    template<class T>
+    T read()
+    {
+        T x{};
+        read(x);
+        return x;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end_ - pos_); }
+
+private:
+    // Every element takes at least 'min_item_size' bytes, which bounds a sane count
+    // before anything gets allocated for it
+    size_t read_size(size_t min_item_size)
+    {
+        const uint64_t n = read<uint64_t>();
+        if (n > remaining() / min_item_size)
+            throw std::out_of_range("BINARY DATA IS TRUNCATED OR CORRUPT: ELEMENT COUNT EXCEEDS THE REMAINING BYTES");
+        return static_cast<size_t>(n);
+    }
+
+    void copy_out(void* p, size_t n)
+    {
+        if (n > remaining())
+            throw std::out_of_range("BINARY DATA IS TRUNCATED: READ PAST THE END");
+        std::memcpy(p, pos_, n);
+        pos_ += n;
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+template<class T>
+std::vector<char> to_bytes(const T& x) { return binary_writer().write(x).take(); }
+
+template<class T>
+T from_bytes(const std::vector<char>& bytes) { return binary_reader(bytes).read<T>(); }
+
 ///////////////////////////////////////////////////////////////////////////////////////////// USEFUL MISC
 
 // Repeats a string patterns.
@@ -1964,8 +5585,16 @@ void generate_random(Iterable& c, int size = 10) // TODO: Maybe generalize this
     ZEN_STATIC_ASSERT(zen::is_iterable_v< Iterable>, "TEMPLATE PARAMETER EXPECTED TO BE Iterable, BUT IS NOT");
     ZEN_STATIC_ASSERT(zen::is_resizable_v<Iterable>, "TEMPLATE PARAMETER EXPECTED TO BE RESIZABLE, BUT IS NOT");
 
-    if (std::empty(c))
+    if (std::empty(c)) {
+        if constexpr (requires { c.reserve(size_t()); c.push_back(random_int(10, 99)); }) {
+            // Reserve and append, rather than zero-fill with resize() and then overwrite
+            c.reserve(static_cast<size_t>(size));
+            for (int i = 0; i < size; ++i)
+                c.push_back(random_int(10, 99));
+            return;
+        }
         c.resize(size);
+    }
 
     std::generate(std::begin(c), std::end(c), [&]() { return random_int(10, 99); });
 }
@@ -2013,13 +5642,22 @@ auto count(const Iterable& c, const EqualityComparable& x)
     ZEN_STATIC_ASSERT(is_equality_comparable_v<EqualityComparable>,
         "TEMPLATE PARAMETER EqualityComparable EXPECTED TO BE EqualityComparable, BUT IS NOT");
 
-    size_t count = 0;
-    for (auto it = std::begin(c); it != std::end(c); ++it) {
-        if (*it == x)
-            ++count;
+    using T = std::remove_cvref_t<decltype(*std::begin(c))>;
+    if constexpr (std::ranges::contiguous_range<const Iterable> && std::ranges::sized_range<const Iterable>
+                  && internal::is_simd_searchable_v<T>
+                  && std::is_same_v<T, EqualityComparable>) {
+        const T* const first = std::ranges::data(c);
+        return internal::simd_count(first, first + std::ranges::size(c), x);
     }
+    else {
+        size_t count = 0;
+        for (auto it = std::begin(c); it != std::end(c); ++it) {
+            if (*it == x)
+                ++count;
+        }
 
-    return count;
+        return count;
+    }
 }
 
 template<class Iterable, class Pred>
@@ -2048,6 +5686,138 @@ auto count_if(const Iterable& c, Pred p)
 // 2. print()     - uses to_string() to output the object (as a string)
 // 3. log()       - uses print() and adds any formatting, new lines at the end, etc.
 
+// ------------------------------------------------------------------------------------------ format_into
+
+// A fixed-capacity output buffer for format_into(), e.g. on the stack.
+// Output that doesn't fit is dropped, which truncated() then reports.
+// Example: zen::fixed_buffer<64> buf; zen::format_into(buf, "x =", 42); // buf.view() == "x = 42"
+template<size_t N>
+class fixed_buffer {
+public:
+    void append(const char* s, size_t n)
+    {
+        const size_t fits = std::min(n, N - size_);
+        std::copy_n(s, fits, data_ + size_);
+        size_      += fits;
+        truncated_ |= fits != n;
+    }
+
+    const char*      data()      const { return data_; }
+    size_t           size()      const { return size_; }
+    std::string_view view()      const { return { data_, size_ }; }
+    bool             truncated() const { return truncated_; }
+    void             clear()           { size_ = 0; truncated_ = false; }
+
+private:
+    char   data_[N];
+    size_t size_      = 0;
+    bool   truncated_ = false;
+};
+
+namespace internal {
+    // Integers that streams print as numbers (bool and the char types print differently)
+    template<class T>
+    constexpr bool is_plain_integer_v = std::is_integral_v<T>
+        && !std::is_same_v<T, bool>
+        && !std::is_same_v<T, char>     && !std::is_same_v<T, signed char> && !std::is_same_v<T, unsigned char>
+        && !std::is_same_v<T, wchar_t>
+#if __cpp_char8_t
+        && !std::is_same_v<T, char8_t>
+#endif
+        && !std::is_same_v<T, char16_t> && !std::is_same_v<T, char32_t>;
+
+    // Lets operator<< write straight into a format_into() sink, for the types with no faster path
+    template<class Sink>
+    class sink_streambuf : public std::streambuf {
+    public:
+        explicit sink_streambuf(Sink& out) : out_(out) {}
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                const char ch = traits_type::to_char_type(c);
+                out_.append(&ch, 1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            out_.append(s, static_cast<size_t>(n));
+            return n;
+        }
+
+    private:
+        Sink& out_;
+    };
+} // namespace internal
+
+// Appends the text to_string(x) returns to 'out', which can be a std::string, a zen::string,
+// a zen::fixed_buffer or anything else with an append(const char*, size_t) member.
+// Nested containers are written element by element, with no temporary strings or streams.
+// Example: std::string line; zen::format_into(line, "took", 42, "ms"); // line == "took 42 ms"
+template<class Sink, class T>
+void format_into(Sink& out, const T& x)
+{
+    // First check for string-likeness so that zen::print("abc") prints "abc"
+    // and not [a, b, c] as a result of considering strings as iterable below
+    if constexpr (is_string_like<T>()) {
+        if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            const std::string_view s = x;
+            out.append(s.data(), s.size());
+        } else {
+            const std::string s = x;
+            out.append(s.data(), s.size());
+        }
+    } else if constexpr (internal::is_plain_integer_v<T>) {
+        char buf[std::numeric_limits<T>::digits10 + 3]; // the sign and the partial last digit
+        out.append(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof buf, x).ptr - buf));
+    } else if constexpr (std::is_same_v<T, bool>) {
+        out.append(x ? "1" : "0", 1); // as an ostream without std::boolalpha prints it
+    } else if constexpr (std::is_same_v<T, char>) {
+        out.append(&x, 1);
+#if __cpp_lib_to_chars >= 201611L
+    } else if constexpr (std::is_floating_point_v<T>) {
+        // The default ostream format is %g with 6 significant digits
+        char buf[32];
+        out.append(buf, static_cast<size_t>(std::to_chars(buf, buf + sizeof buf, x, std::chars_format::general, 6).ptr - buf));
+#endif
+    } else if constexpr (is_iterable_v<T>) {
+        out.append("[", 1);
+        bool first = true;
+        for (const auto& item : x) {
+            if (!first)
+                out.append(", ", 2);
+            first = false;
+
+            if constexpr (is_string_like<decltype(item)>()) {
+                out.append("\"", 1);
+                format_into(out, item);
+                out.append("\"", 1);
+            } else {
+                format_into(out, item); // recursive call to handle nested iterables
+            }
+        }
+        out.append("]", 1);
+    } else { // anything else that has an operator<<
+        internal::sink_streambuf<Sink> buf(out);
+        std::ostream os(&buf);
+        os << x;
+    }
+}
+
+// Recursive variadic version that separates the items with spaces
+template<class Sink, class T, class... Args>
+void format_into(Sink& out, const T& x, const Args&... args)
+{
+    format_into(out, x);
+    ((out.append(" ", 1), format_into(out, args)), ...);
+}
+// Base case for the recursive calls
+template<class Sink>
+void format_into(Sink&) {}
+
 // ------------------------------------------------------------------------------------------ stringify
 
 // Converts most of the widely used data types to a string.
@@ -2056,84 +5826,352 @@ auto count_if(const Iterable& c, Pred p)
 // Example: to_string(42)  Result: "42"
 template<class T>
 zen::string to_string(const T& x) {
-    std::stringstream ss;
-    
-    // First check for string-likeness so that zen::pring("abc") prints "abc"
-    // and not [a, b, c] as a result of considering strings as iterable below
-    if constexpr (is_string_like<T>()) {
-        return x;
-    } else if constexpr (is_iterable_v<T>) {
-        ss << "[";
-        auto it = std::begin(x);
-        if (it != std::end(x)) {
-            if constexpr (is_string_like<decltype(*it)>())
-                ss << quote(to_string(*it++));
-            else
-                ss << to_string(*it++);              // recursive call to handle nested iterables
-        }
-        for (; it != std::end(x); ++it) {
-            if constexpr (is_string_like<decltype(*it)>())
-                ss << ", " << quote(to_string(*it)); // recursive call to handle nested iterables
-            else
-                ss << ", " << to_string(*it);        // recursive call to handle nested iterables
-        }
-        ss << "]";
-    } else { // not iterable, single item
-        ss << x;
-    }
-    return ss.str();
+    zen::string s;
+    format_into(s, x);
+    return s;
 }
 
-// Recursive variadic template to handle multiple arguments
+// Variadic version that separates the items with spaces
 template<class T, class... Args>
 inline zen::string to_string(const T& x, const Args&... args) {
-    return to_string(x) + " " + to_string(args...);
+    zen::string s;
+    format_into(s, x, args...);
+    return s;
 }
 // Base case for the recursive calls
 inline zen::string to_string() { return ""; }
 
-// ------------------------------------------------------------------------------------------ print
+namespace internal {
+    // print() and log() format into a per-thread buffer that keeps its capacity between
+    // calls, then hand it to std::cout in a single write. The buffer is moved out while
+    // in use, so a print() nested in some operator<< just gets a fresh one.
+    inline std::string& print_buffer()
+    {
+        thread_local std::string buffer;
+        return buffer;
+    }
 
-// Function to handle individual item printing
-template <class T>
-void print(const T& x)
-{
-    std::cout << to_string(x);
-}
+    template<class... Args>
+    void write_to_cout(const std::string_view tail, bool flush, const Args&... args)
+    {
+        std::string buffer = std::move(print_buffer());
+        buffer.clear();
+        format_into(buffer, args...);
+        buffer += tail;
+
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (flush)
+            std::cout.flush();
+
+        print_buffer() = std::move(buffer);
+    }
+} // namespace internal
+
+// ------------------------------------------------------------------------------------------ print
 
 // Generic, almost Python-like print(). Works like this:
 // print("Hello", "World", vec, 42); // Output: Hello World [1, 2, 3] 42
 // print("Hello", "World", 24, vec); // Output: Hello World 24 [1, 2, 3]
 // print("Hello", vec, 42, "World"); // Output: Hello [1, 2, 3] 42 World
 template <class T, class... Args>
-void print(T x, Args... args) {
-    print(x);
-    if constexpr (sizeof...(args) != 0) {
-        std::cout << " ";
-    }
-    print(args...);
+void print(const T& x, const Args&... args) {
+    internal::write_to_cout("", false, x, args...);
 }
 // Base case for the recursive calls
 inline void print() {}
 
 // ------------------------------------------------------------------------------------------ log
 
-// Handles logging a single item
+// Handles logging a single item, followed by a space and a new line
 template <class T>
 void log(const T& x)
 {
-    print(x, '\n');
+    internal::write_to_cout(" \n", false, x);
 }
 
 // Generic, almost Python-like log(). Works similar to the print() function but adds std::endl
 template <class T, class... Args>
-void log(T x, Args... args) {
-    print(x, args...);
-    std::cout << std::endl;
+void log(const T& x, const Args&... args) {
+    internal::write_to_cout("\n", true, x, args...);
 }
 // Base case for the recursive calls
 inline void log() {}
 
+// ------------------------------------------------------------------------------------------ async_logger
+
+// When an async_logger pushes its buffered output on to the OS with fflush()
+enum class flush_policy {
+    every_batch, // after every batch the writer thread writes
+    when_idle,   // once the writer thread runs out of lines to write (the default)
+    on_demand,   // only in flush() and on destruction
+};
+
+namespace internal {
+    // Single-producer, single-consumer ring of bytes. The capacity is a power of two, and
+    // the positions only ever grow, so 'head - tail' is the number of readable bytes.
+    class byte_ring {
+    public:
+        explicit byte_ring(size_t capacity) : capacity_(round_up_to_power_of_two(capacity)), data_(new char[capacity_]) {}
+
+        size_t capacity() const { return capacity_; }
+
+        // Producer side: all of [s, s + n) or nothing
+        bool try_push(const char* s, size_t n)
+        {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (capacity_ - (head - tail_.load(std::memory_order_acquire)) < n)
+                return false;
+
+            const size_t at    = head & (capacity_ - 1);
+            const size_t first = std::min(n, capacity_ - at);
+            std::memcpy(data_.get() + at, s, first);
+            std::memcpy(data_.get(), s + first, n - first);
+            head_.store(head + n, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer side: hands all readable bytes to out(ptr, size), in at most two pieces
+        template<class Out>
+        size_t drain(Out out)
+        {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            const size_t n    = head_.load(std::memory_order_acquire) - tail;
+            if (n == 0)
+                return 0;
+
+            const size_t at    = tail & (capacity_ - 1);
+            const size_t first = std::min(n, capacity_ - at);
+            out(data_.get() + at, first);
+            if (first != n)
+                out(data_.get(), n - first);
+            tail_.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+        std::atomic<bool> closed{false}; // set when the producer thread exits or the logger goes away
+
+    private:
+        // std::bit_ceil() without <bit>'s C++20 requirement
+        static size_t round_up_to_power_of_two(size_t n)
+        {
+            size_t p = 1;
+            while (p < n)
+                p <<= 1;
+            return p;
+        }
+
+        const size_t            capacity_;
+        std::unique_ptr<char[]> data_;
+        alignas(64) std::atomic<size_t> head_{0}; // written by the producer only
+        alignas(64) std::atomic<size_t> tail_{0}; // written by the consumer only
+    };
+} // namespace internal
+
+// A logger whose log() only formats the line and copies it into a lock-free ring owned by
+// the calling thread. A background thread collects the lines from all rings and writes them
+// to the FILE* in large batches, so the logging thread makes no system call per line.
+// Lines of one thread keep their order; lines longer than a ring may interleave with others.
+// Example: zen::async_logger logger(stdout);
+//          logger.log("request", id, "served in", ms, "ms"); // Output: request 42 served in 12 ms
+class async_logger {
+public:
+    struct options {
+        size_t                    ring_capacity = 64 * 1024;  // bytes per logging thread
+        size_t                    batch_size    = 256 * 1024; // bytes per fwrite() call
+        zen::flush_policy         flush_policy  = zen::flush_policy::when_idle;
+        std::chrono::microseconds idle_sleep{500};             // how long the writer sleeps when there is nothing to write,
+                                                               // unless a full ring or flush() wakes it up
+    };
+
+    explicit async_logger(std::FILE* out = stdout) : async_logger(out, options{}) {}
+
+    async_logger(std::FILE* out, const options& opts)
+        : out_(out), opts_(opts), id_(next_id()), writer_([this] { run(); })
+    {}
+
+    async_logger(const async_logger&)            = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    // Writes everything logged so far, then stops the writer thread. The rings are closed
+    // afterwards, so producer threads drop them and a write() still waiting on a full one returns.
+    ~async_logger()
+    {
+        stop_.store(true, std::memory_order_release);
+        wake_writer();
+        writer_.join();
+
+        std::lock_guard lock(rings_mutex_);
+        for (auto& ring : rings_)
+            ring->closed.store(true, std::memory_order_release);
+    }
+
+    // Formats the items like zen::log(), separated by spaces and followed by a new line
+    template<class... Args>
+    void log(const Args&... args)
+    {
+        std::string& line = line_buffer();
+        line.clear();
+        format_into(line, args...);
+        line += '\n';
+        write(line);
+    }
+
+    // Queues already formatted text as is
+    void write(std::string_view text)
+    {
+        internal::byte_ring& ring = local_ring();
+        while (!text.empty()) {
+            const size_t chunk = std::min(text.size(), ring.capacity());
+            if (!ring.try_push(text.data(), chunk)) {
+                wake_writer(); // the ring is full: wait for the writer rather than drop lines
+                while (!ring.try_push(text.data(), chunk)) {
+                    if (ring.closed.load(std::memory_order_acquire))
+                        return; // the logger is being destroyed, nobody will drain the ring
+                    std::this_thread::yield();
+                }
+            }
+            text.remove_prefix(chunk);
+        }
+    }
+
+    // Blocks until everything logged before the call has been written and fflush()ed
+    void flush()
+    {
+        const uint64_t ticket = flush_requests_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wake_writer();
+        while (flushed_.load(std::memory_order_acquire) < ticket)
+            std::this_thread::yield();
+    }
+
+private:
+    // Each thread's rings, one per live logger it has used. A ring is shared with the logger,
+    // so either of them can go away first; the entries of destroyed loggers are swept out
+    // whenever the thread meets a logger it has no ring for yet.
+    struct thread_rings {
+        std::vector<std::pair<uint64_t, std::shared_ptr<internal::byte_ring>>> rings;
+
+        ~thread_rings()
+        {
+            for (auto& [id, ring] : rings)
+                ring->closed.store(true, std::memory_order_release);
+        }
+    };
+
+    static uint64_t next_id()
+    {
+        static std::atomic<uint64_t> id{0};
+        return ++id;
+    }
+
+    static std::string& line_buffer()
+    {
+        thread_local std::string line;
+        return line;
+    }
+
+    void wake_writer()
+    {
+        {
+            std::lock_guard lock(wake_mutex_);
+            wake_requested_ = true;
+        }
+        wake_.notify_one();
+    }
+
+    internal::byte_ring& local_ring()
+    {
+        thread_local thread_rings local;
+        for (auto& [id, ring] : local.rings)
+            if (id == id_)
+                return *ring;
+
+        local.rings.erase(std::remove_if(local.rings.begin(), local.rings.end(),
+                                         [](const auto& entry) { return entry.second->closed.load(std::memory_order_acquire); }),
+                          local.rings.end());
+
+        auto ring = std::make_shared<internal::byte_ring>(opts_.ring_capacity);
+        {
+            std::lock_guard lock(rings_mutex_);
+            rings_.push_back(ring);
+        }
+        local.rings.emplace_back(id_, ring);
+        return *ring;
+    }
+
+    void run()
+    {
+        std::string batch;
+        batch.reserve(opts_.batch_size);
+        bool unflushed = false;
+
+        const auto write_batch = [&] {
+            if (batch.empty())
+                return;
+            std::fwrite(batch.data(), 1, batch.size(), out_);
+            batch.clear();
+            unflushed = true;
+            if (opts_.flush_policy == zen::flush_policy::every_batch) {
+                std::fflush(out_);
+                unflushed = false;
+            }
+        };
+
+        for (;;) {
+            // Read before draining, so that whatever was logged before them gets drained below
+            const bool     stopping  = stop_.load(std::memory_order_acquire);
+            const uint64_t requested = flush_requests_.load(std::memory_order_acquire);
+
+            size_t drained = 0;
+            {
+                std::lock_guard lock(rings_mutex_);
+                for (auto& ring : rings_) {
+                    drained += ring->drain([&](const char* s, size_t n) {
+                        batch.append(s, n);
+                        if (batch.size() >= opts_.batch_size)
+                            write_batch();
+                    });
+                }
+                // The rings of exited threads are dropped once they are empty
+                rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                            [](const auto& ring) { return ring->closed.load(std::memory_order_acquire) && ring->empty(); }),
+                             rings_.end());
+            }
+            write_batch();
+
+            const bool idle = drained == 0;
+            if (unflushed && (stopping || requested != flushed_.load(std::memory_order_relaxed)
+                              || (idle && opts_.flush_policy == zen::flush_policy::when_idle))) {
+                std::fflush(out_);
+                unflushed = false;
+            }
+            flushed_.store(requested, std::memory_order_release);
+
+            if (stopping)
+                break;
+            if (idle) {
+                std::unique_lock lock(wake_mutex_);
+                wake_.wait_for(lock, opts_.idle_sleep, [this] { return wake_requested_; });
+                wake_requested_ = false;
+            }
+        }
+    }
+
+    std::FILE* const                                   out_;
+    const options                                      opts_;
+    const uint64_t                                     id_;
+    std::mutex                                         rings_mutex_;
+    std::vector<std::shared_ptr<internal::byte_ring>>  rings_;
+    std::atomic<bool>                                  stop_{false};
+    std::atomic<uint64_t>                              flush_requests_{0};
+    std::atomic<uint64_t>                              flushed_{0};
+    std::mutex                                         wake_mutex_;
+    std::condition_variable                            wake_;
+    bool                                               wake_requested_ = false;
+    std::thread                                        writer_; // last, so it starts after everything it uses
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////// COMPOSITES
 
 // Following are some of the most common data types defined in
@@ -2142,16 +6180,16 @@ inline void log() {}
 
 template<
     class T,
-    class H = std::hash<T>,
-    class E = std::equal_to<T>,
+    class H = internal::default_hash<T>,
+    class E = internal::default_equal<T>,
     class A = std::allocator<T>
 >
 using hash_set = zen::unordered_set<T, H, E, A>;
 
 template<
     class T,
-    class H = std::hash<T>,
-    class E = std::equal_to<T>,
+    class H = internal::default_hash<T>,
+    class E = internal::default_equal<T>,
     class A = std::allocator<T>
 >
 using hash_multiset = zen::unordered_multiset<T, H, E, A>;
@@ -2159,17 +6197,21 @@ using hash_multiset = zen::unordered_multiset<T, H, E, A>;
 template<
     class K,
     class V,
-    class H = std::hash<K>,
-    class E = std::equal_to<K>,
+    class H = internal::default_hash<K>,
+    class E = internal::default_equal<K>,
     class A = std::allocator<std::pair<const K, V>>
 >
+#ifdef ZEN_HASH_MAP_FLAT // opt into the open-addressing backend, see zen::flat_hash_map
+using hash_map = zen::flat_hash_map<K, V, H, E, A>;
+#else
 using hash_map = zen::unordered_map<K, V, H, E, A>;
+#endif
 
 template<
     class K,
     class V,
-    class H = std::hash<K>,
-    class E = std::equal_to<K>,
+    class H = internal::default_hash<K>,
+    class E = internal::default_equal<K>,
     class A = std::allocator<std::pair<const K, V>>
 >
 using hash_multimap = zen::unordered_multimap<K, V, H, E, A>;
@@ -2,6 +2,32 @@
 #include <vector>
 #include <chrono>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <random>
+
+#include "fast_math.h"
+#include "kaizen.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Per-function ISA targets (GCC/Clang on x86) let SIMD paths coexist with the baseline build
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #define HAS_X86_TARGET_ATTRIBUTES 1
+#else
+  #define HAS_X86_TARGET_ATTRIBUTES 0
+#endif
+
+// target_clones needs ifunc support from the loader, which only ELF platforms provide
+#if HAS_X86_TARGET_ATTRIBUTES && defined(__linux__)
+  #define HAS_TARGET_CLONES 1
+#else
+  #define HAS_TARGET_CLONES 0
+#endif
 
 void print_header(const std::string& title)
 {
@@ -10,21 +36,189 @@ void print_header(const std::string& title)
 	std::cout << std::setw(60) << std::setfill('=') << "\n";
 }
 
+// Runtime CPU dispatch: each ISA level gets its own copy of the reduction, copy and
+// compute_original kernels, compiled with a per-function target attribute, so one
+// portable binary can use AVX2/AVX-512 without building everything with -march=native.
+long long sum_baseline(const int* data, size_t n) {
+	long long sum = 0;
+	for (size_t i = 0; i < n; ++i)
+		sum += data[i];
+	return sum;
+}
+
+void copy_baseline(const int* src, int* dst, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+		dst[i] = src[i];
+}
+
+void compute_baseline(const float* a, const float* b, float* out, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+		out[i] = a[i] * 2.0f + b[i] * 3.0f - 10.0f;
+}
+
+#if HAS_X86_TARGET_ATTRIBUTES
+__attribute__((target("sse4.2")))
+long long sum_sse42(const int* data, size_t n) {
+	__m128i acc = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+		acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+		acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+	}
+	long long lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+	return lanes[0] + lanes[1] + sum_baseline(data + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+void copy_sse42(const int* src, int* dst, size_t n) {
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+	copy_baseline(src + i, dst + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+void compute_sse42(const float* a, const float* b, float* out, size_t n) {
+	const __m128 two = _mm_set1_ps(2.0f), three = _mm_set1_ps(3.0f), ten = _mm_set1_ps(10.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128 va = _mm_mul_ps(_mm_loadu_ps(a + i), two);
+		const __m128 vb = _mm_mul_ps(_mm_loadu_ps(b + i), three);
+		_mm_storeu_ps(out + i, _mm_sub_ps(_mm_add_ps(va, vb), ten));
+	}
+	compute_baseline(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+long long sum_avx2(const int* data, size_t n) {
+	__m256i acc = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+		acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+	}
+	long long lanes[4];
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_baseline(data + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void copy_avx2(const int* src, int* dst, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+	copy_baseline(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void compute_avx2(const float* a, const float* b, float* out, size_t n) {
+	const __m256 two = _mm256_set1_ps(2.0f), three = _mm256_set1_ps(3.0f), ten = _mm256_set1_ps(10.0f);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 va = _mm256_mul_ps(_mm256_loadu_ps(a + i), two);
+		const __m256 vb = _mm256_mul_ps(_mm256_loadu_ps(b + i), three);
+		_mm256_storeu_ps(out + i, _mm256_sub_ps(_mm256_add_ps(va, vb), ten));
+	}
+	compute_baseline(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+long long sum_avx512(const int* data, size_t n) {
+	// The maskz widening and the lane-by-lane reduction avoid the intrinsics built on
+	// _mm512_undefined_epi32(), which GCC 12 reports as uninitialized under -Wall
+	__m512i acc = _mm512_setzero_si512();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		acc = _mm512_add_epi64(acc, _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+		acc = _mm512_add_epi64(acc, _mm512_maskz_cvtepi32_epi64(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8))));
+	}
+	long long lanes[8];
+	_mm512_storeu_si512(lanes, acc);
+	long long sum = 0;
+	for (long long lane : lanes)
+		sum += lane;
+	return sum + sum_baseline(data + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void copy_avx512(const int* src, int* dst, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16)
+		_mm512_storeu_si512(dst + i, _mm512_loadu_si512(src + i));
+	copy_baseline(src + i, dst + i, n - i);
+}
+
+__attribute__((target("avx512f")))
+void compute_avx512(const float* a, const float* b, float* out, size_t n) {
+	const __m512 two = _mm512_set1_ps(2.0f), three = _mm512_set1_ps(3.0f), ten = _mm512_set1_ps(10.0f);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m512 va = _mm512_mul_ps(_mm512_loadu_ps(a + i), two);
+		const __m512 vb = _mm512_mul_ps(_mm512_loadu_ps(b + i), three);
+		_mm512_storeu_ps(out + i, _mm512_sub_ps(_mm512_add_ps(va, vb), ten));
+	}
+	compute_baseline(a + i, b + i, out + i, n - i);
+}
+#endif
+
+#if HAS_TARGET_CLONES
+// The compiler-generated alternative: one source loop, cloned per target and
+// resolved through an ifunc by the dynamic loader
+__attribute__((target_clones("avx512f", "avx2", "sse4.2", "default")))
+void compute_target_clones(const float* a, const float* b, float* out, size_t n) {
+	for (size_t i = 0; i < n; ++i)
+		out[i] = a[i] * 2.0f + b[i] * 3.0f - 10.0f;
+}
+#endif
+
+struct kernel_table {
+	const char* isa;
+	bool (*supported)();
+	long long (*sum)(const int*, size_t);
+	void (*copy)(const int*, int*, size_t);
+	void (*compute)(const float*, const float*, float*, size_t);
+};
+
+// Ordered from the most portable to the most specialized. __builtin_cpu_supports
+// queries cpuid once at startup and also accounts for OS support of the wider registers.
+const kernel_table kernel_tables[] = {
+	{ "baseline", [] { return true; }, sum_baseline, copy_baseline, compute_baseline },
+#if HAS_X86_TARGET_ATTRIBUTES
+	{ "SSE4.2",  [] { return __builtin_cpu_supports("sse4.2")  != 0; }, sum_sse42,  copy_sse42,  compute_sse42  },
+	{ "AVX2",    [] { return __builtin_cpu_supports("avx2")    != 0; }, sum_avx2,   copy_avx2,   compute_avx2   },
+	{ "AVX-512", [] { return __builtin_cpu_supports("avx512f") != 0; }, sum_avx512, copy_avx512, compute_avx512 },
+#endif
+};
+
+// Resolved once, the first time any dispatched kernel is needed
+const kernel_table& active_kernels() {
+	static const kernel_table& selected = []() -> const kernel_table& {
+		const kernel_table* best = &kernel_tables[0];
+		for (const auto& table : kernel_tables)
+			if (table.supported())
+				best = &table;
+		return *best;
+	}();
+	return selected;
+}
+
 void test_optimization()
 {
 	const size_t size = 100000000;
 	std::vector<int> data(size, 1);
+	const kernel_table& kernels = active_kernels();
 
 	auto start = std::chrono::high_resolution_clock::now();
 
-	long long sum = 0;
-	for (size_t i = 0; i < size; ++i)
-		sum += data[i];
+	const long long sum = kernels.sum(data.data(), size);
 
 	auto end = std::chrono::high_resolution_clock::now();
 	std::chrono::duration<double> elapsed = end - start;
 
-	std::cout << "Sum: " << sum << "\n";
+	std::cout << "Sum: " << sum << " (" << kernels.isa << " kernel)\n";
 	std::cout << "Elapsed time: " << elapsed.count() << " seconds\n";
 }
 
@@ -114,9 +308,15 @@ void test_loop_unrolling()
 	std::chrono::duration<double> elapsed_unrolled = end - start;
 	std::cout << "Unrolled copy time: " << elapsed_unrolled.count() << " seconds\n";
 
-	long long sum = 0;
-	for (size_t j = 0; j < size; ++j)
-		sum += dst[j];
+	std::fill(dst.begin(), dst.end(), 0);
+
+	const kernel_table& kernels = active_kernels();
+	start = std::chrono::high_resolution_clock::now();
+	kernels.copy(src.data(), dst.data(), size);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> elapsed_dispatched = end - start;
+	std::cout << "Dispatched (" << kernels.isa << ") copy time: " << elapsed_dispatched.count() << " seconds"
+	          << (kernels.sum(dst.data(), size) == static_cast<long long>(size) ? "" : " (WRONG RESULT)") << "\n";
 }
 
 void test_sso_performance() {
@@ -194,140 +394,2021 @@ void test_direct_call(int iterations) {
 }
 
 
+// out[i] = a[i] * 2 + b[i] * 3 - 10, through the kernel picked for this CPU at startup
 void compute_original(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& out) {
+	active_kernels().compute(a.data(), b.data(), out.data(), a.size());
+}
+
+void compute_fma(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& out) {
 	size_t n = a.size();
 	for (size_t i = 0; i < n; ++i)
-		out[i] = a[i] * 2.0f + b[i] * 3.0f - 10.0f;
+		out[i] = std::fma(a[i], 2.0f, std::fma(b[i], 3.0f, -10.0f));
 }
 
-void compute_simplified(const std::vector<float>& a, const std::vector<float>& b, std::vector<float>& out) {
-	size_t n = a.size();
+// Naive power form: every term recomputes its power of x
+void poly_power(const float* x, float* out, size_t n) {
+	const float* c = poly_coeffs;
+	for (size_t i = 0; i < n; ++i) {
+		const float v = x[i];
+		out[i] = c[0] + c[1] * v + c[2] * v * v + c[3] * v * v * v
+		       + c[4] * v * v * v * v + c[5] * v * v * v * v * v;
+	}
+}
+
+// Horner form: 5 multiplies and 5 adds instead of 15 multiplies and 5 adds
+template<class T>
+void poly_horner(const float* x, T* out, size_t n) {
+	const float* c = poly_coeffs;
+	for (size_t i = 0; i < n; ++i) {
+		const T v = x[i];
+		out[i] = ((((T(c[5]) * v + T(c[4])) * v + T(c[3])) * v + T(c[2])) * v + T(c[1])) * v + T(c[0]);
+	}
+}
+
+void poly_horner_fma(const float* x, float* out, size_t n) {
+	const float* c = poly_coeffs;
+	for (size_t i = 0; i < n; ++i) {
+		const float v = x[i];
+		out[i] = std::fma(std::fma(std::fma(std::fma(std::fma(c[5], v, c[4]), v, c[3]), v, c[2]), v, c[1]), v, c[0]);
+	}
+}
+
+#if HAS_X86_TARGET_ATTRIBUTES
+__attribute__((target("avx2,fma")))
+void poly_horner_fma_avx2(const float* x, float* out, size_t n) {
+	const float* c = poly_coeffs;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256 v = _mm256_loadu_ps(x + i);
+		__m256 acc = _mm256_set1_ps(c[5]);
+		acc = _mm256_fmadd_ps(acc, v, _mm256_set1_ps(c[4]));
+		acc = _mm256_fmadd_ps(acc, v, _mm256_set1_ps(c[3]));
+		acc = _mm256_fmadd_ps(acc, v, _mm256_set1_ps(c[2]));
+		acc = _mm256_fmadd_ps(acc, v, _mm256_set1_ps(c[1]));
+		acc = _mm256_fmadd_ps(acc, v, _mm256_set1_ps(c[0]));
+		_mm256_storeu_ps(out + i, acc);
+	}
+	poly_horner_fma(x + i, out + i, n - i);
+}
+#endif
+
+// Emulates bfloat16 storage: keeps the upper 16 bits of a float, rounding to nearest even
+float to_bfloat16(float f) {
+	if (std::isnan(f))
+		return f;
+	uint32_t bits;
+	std::memcpy(&bits, &f, sizeof(bits));
+	bits += 0x7FFF + ((bits >> 16) & 1);
+	bits &= 0xFFFF0000u;
+	std::memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+void poly_horner_bfloat16(const float* x, float* out, size_t n) {
+	float c[6];
+	for (int k = 0; k < 6; ++k)
+		c[k] = to_bfloat16(poly_coeffs[k]);
+	for (size_t i = 0; i < n; ++i) {
+		const float v = to_bfloat16(x[i]);
+		float acc = c[5];
+		for (int k = 4; k >= 0; --k)
+			acc = to_bfloat16(to_bfloat16(acc * v) + c[k]);
+		out[i] = acc;
+	}
+}
+
+template<class T>
+void report_variant(const std::string& name, std::chrono::duration<double> elapsed, const std::vector<T>& out,
+                    const std::vector<long double>& reference)
+{
+	const size_t n = out.size();
+	long double max_error = 0;
 	for (size_t i = 0; i < n; ++i)
-		out[i] = (a[i] * 2.0f) + (b[i] * 3.0f) - 10.0f;
+		max_error = std::max(max_error, std::abs(static_cast<long double>(out[i]) - reference[i]));
+
+	std::cout << std::left << std::setfill(' ') << std::setw(24) << name << std::right
+	          << "time: " << elapsed.count() << " s, "
+	          << n / elapsed.count() / 1e6 << " M elems/s, "
+	          << "max error: " << static_cast<double>(max_error) << "\n";
+}
+
+template<class T, class Kernel>
+void run_precision_variant(const std::string& name, Kernel kernel, const std::vector<float>& x,
+                           const std::vector<long double>& reference)
+{
+	std::vector<T> out(x.size());
+
+	auto start = std::chrono::high_resolution_clock::now();
+	kernel(x.data(), out.data(), x.size());
+	auto end = std::chrono::high_resolution_clock::now();
+
+	report_variant(name, end - start, out, reference);
 }
 
 void test_algorithmic_optimization() {
 	const size_t size = 10000000;
-	std::vector<float> a(size, 1.5f);
-	std::vector<float> b(size, 2.5f);
+	std::vector<float> a(size);
+	std::vector<float> b(size);
 	std::vector<float> out(size, 0.0f);
+	std::vector<long double> reference(size);
+	for (size_t i = 0; i < size; ++i) {
+		a[i] = -100.0f + 200.0f * static_cast<float>(i) / size;
+		b[i] = 100.0f - 300.0f * static_cast<float>(i) / size;
+		reference[i] = static_cast<long double>(a[i]) * 2 + static_cast<long double>(b[i]) * 3 - 10;
+	}
 
 	auto start = std::chrono::high_resolution_clock::now();
 	compute_original(a, b, out);
 	auto end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> time_orig = end - start;
+	report_variant("Original", end - start, out, reference);
 
 	start = std::chrono::high_resolution_clock::now();
-	compute_simplified(a, b, out);
+	compute_fma(a, b, out);
 	end = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> time_simpl = end - start;
+	report_variant("std::fma", end - start, out, reference);
+	std::cout << "\n";
+
+	std::vector<float> x(size);
+	for (size_t i = 0; i < size; ++i) {
+		x[i] = -1.0f + 2.0f * static_cast<float>(i) / size;
+		const long double v = x[i];
+		long double acc = poly_coeffs[5];
+		for (int k = 4; k >= 0; --k)
+			acc = acc * v + poly_coeffs[k];
+		reference[i] = acc;
+	}
 
-	std::cout << "Original time: " << time_orig.count() << " seconds\n";
-	std::cout << "Simplified time: " << time_simpl.count() << " seconds\n";
+	run_precision_variant<float>("Power form float", poly_power, x, reference);
+	run_precision_variant<float>("Power form fast-math", poly_power_fast_math, x, reference);
+	run_precision_variant<float>("Horner float", poly_horner<float>, x, reference);
+	run_precision_variant<float>("Horner fast-math", poly_horner_fast_math, x, reference);
+	run_precision_variant<float>("Horner std::fma", poly_horner_fma, x, reference);
+#if HAS_X86_TARGET_ATTRIBUTES
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		run_precision_variant<float>("Horner AVX2 FMA", poly_horner_fma_avx2, x, reference);
+	else
+		std::cout << "Horner AVX2 FMA         not supported on this CPU\n";
+#endif
+	run_precision_variant<double>("Horner double", poly_horner<double>, x, reference);
+	run_precision_variant<float>("Horner bfloat16", poly_horner_bfloat16, x, reference);
 }
 
-void pointer_dereference(int** matrix, int rows, int cols) {
-	long long sum = 0;
-	for (int i = 0; i < rows; ++i)
-		for (int j = 0; j < cols; ++j)
-			sum += *(*(matrix + i) + j);
-}
+// Expression templates: arithmetic on expr_array values builds a tree of lightweight
+// nodes instead of temporaries, and assignment evaluates the whole tree in one loop.
+template<class E>
+struct array_expr {
+	const E& self() const { return static_cast<const E&>(*this); }
+};
 
-void pointer_elimination(int** matrix, int rows, int cols) {
-	long long sum = 0;
-	for (int i = 0; i < rows; ++i) {
-		int* row_ptr = matrix[i];
-		for (int j = 0; j < cols; ++j)
-			sum += row_ptr[j];
+struct add_op { static float apply(float a, float b) { return a + b; } };
+struct sub_op { static float apply(float a, float b) { return a - b; } };
+struct mul_op { static float apply(float a, float b) { return a * b; } };
+
+class expr_array;
+
+// Leaves (arrays) are held by reference, intermediate nodes by value since they are temporaries
+template<class E> struct expr_storage             { using type = const E; };
+template<>        struct expr_storage<expr_array> { using type = const expr_array&; };
+
+template<class L, class R, class Op>
+struct binary_expr : array_expr<binary_expr<L, R, Op>> {
+	binary_expr(const L& l, const R& r) : lhs(l), rhs(r) {}
+
+	float operator[](size_t i) const { return Op::apply(lhs[i], rhs[i]); }
+	size_t size() const { return lhs.size(); }
+
+	typename expr_storage<L>::type lhs;
+	typename expr_storage<R>::type rhs;
+};
+
+template<class E, class Op, bool ScalarFirst = false>
+struct scalar_expr : array_expr<scalar_expr<E, Op, ScalarFirst>> {
+	scalar_expr(const E& e, float s) : expr(e), scalar(s) {}
+
+	float operator[](size_t i) const {
+		return ScalarFirst ? Op::apply(scalar, expr[i]) : Op::apply(expr[i], scalar);
 	}
-}
+	size_t size() const { return expr.size(); }
 
-void test_pointer_elimination() {
-	const int rows = 1000;
-	const int cols = 1000;
+	typename expr_storage<E>::type expr;
+	float scalar;
+};
 
-	int** matrix = new int*[rows];
-	for (int i = 0; i < rows; ++i) {
-		matrix[i] = new int[cols];
-		for (int j = 0; j < cols; ++j)
-			matrix[i][j] = i + j;
+class expr_array : public array_expr<expr_array> {
+public:
+	expr_array(size_t n, float value = 0.0f) : data_(n, value) {}
+
+	// The single pass: every node of the tree is inlined into this loop
+	template<class E>
+	expr_array& operator=(const array_expr<E>& e) {
+		const E& x = e.self();
+		const size_t n = data_.size();
+		float* out = data_.data();
+		for (size_t i = 0; i < n; ++i)
+			out[i] = x[i];
+		return *this;
+	}
+
+	float  operator[](size_t i) const { return data_[i]; }
+	float& operator[](size_t i)       { return data_[i]; }
+	size_t size() const { return data_.size(); }
+
+private:
+	std::vector<float> data_;
+};
+
+template<class L, class R>
+binary_expr<L, R, add_op> operator+(const array_expr<L>& l, const array_expr<R>& r) { return { l.self(), r.self() }; }
+template<class L, class R>
+binary_expr<L, R, sub_op> operator-(const array_expr<L>& l, const array_expr<R>& r) { return { l.self(), r.self() }; }
+template<class L, class R>
+binary_expr<L, R, mul_op> operator*(const array_expr<L>& l, const array_expr<R>& r) { return { l.self(), r.self() }; }
+
+template<class E> scalar_expr<E, add_op> operator+(const array_expr<E>& e, float s) { return { e.self(), s }; }
+template<class E> scalar_expr<E, sub_op> operator-(const array_expr<E>& e, float s) { return { e.self(), s }; }
+template<class E> scalar_expr<E, mul_op> operator*(const array_expr<E>& e, float s) { return { e.self(), s }; }
+template<class E> scalar_expr<E, add_op> operator+(float s, const array_expr<E>& e) { return { e.self(), s }; }
+template<class E> scalar_expr<E, mul_op> operator*(float s, const array_expr<E>& e) { return { e.self(), s }; }
+template<class E> scalar_expr<E, sub_op, true> operator-(float s, const array_expr<E>& e) { return { e.self(), s }; }
+
+// The textbook alternative: every operator materializes its result in a fresh array
+class naive_array {
+public:
+	naive_array(size_t n, float value = 0.0f) : data_(n, value) {}
+
+	float  operator[](size_t i) const { return data_[i]; }
+	float& operator[](size_t i)       { return data_[i]; }
+	size_t size() const { return data_.size(); }
+
+	friend naive_array operator+(const naive_array& a, const naive_array& b) {
+		naive_array r(a.size());
+		for (size_t i = 0; i < a.size(); ++i)
+			r[i] = a[i] + b[i];
+		return r;
+	}
+	friend naive_array operator-(const naive_array& a, float s) {
+		naive_array r(a.size());
+		for (size_t i = 0; i < a.size(); ++i)
+			r[i] = a[i] - s;
+		return r;
+	}
+	friend naive_array operator*(const naive_array& a, float s) {
+		naive_array r(a.size());
+		for (size_t i = 0; i < a.size(); ++i)
+			r[i] = a[i] * s;
+		return r;
 	}
 
+private:
+	std::vector<float> data_;
+};
+
+void test_expression_templates() {
+	const size_t size = 10000000;
+
+	std::vector<float> a(size, 1.5f);
+	std::vector<float> b(size, 2.5f);
+	std::vector<float> out(size, 0.0f);
+
 	auto start = std::chrono::high_resolution_clock::now();
-	pointer_dereference(matrix, rows, cols);
+	compute_original(a, b, out);
 	auto end = std::chrono::high_resolution_clock::now();
-	std::cout << "Pointer dereference time: " << std::chrono::duration<double>(end - start).count() << " s\n";
+	std::chrono::duration<double> time_loop = end - start;
 
+	// Scalar hand loop, the reference the expression templates must match
+	std::vector<float> out_scalar(size, 0.0f);
 	start = std::chrono::high_resolution_clock::now();
-	pointer_elimination(matrix, rows, cols);
+	compute_baseline(a.data(), b.data(), out_scalar.data(), size);
 	end = std::chrono::high_resolution_clock::now();
-	std::cout << "Pointer elimination time: " << std::chrono::duration<double>(end - start).count() << " s\n";
+	std::chrono::duration<double> time_scalar = end - start;
 
-	for (int i = 0; i < rows; ++i)
-		delete[] matrix[i];
-	delete[] matrix;
+	naive_array na(size, 1.5f);
+	naive_array nb(size, 2.5f);
+	naive_array nout(size);
+
+	start = std::chrono::high_resolution_clock::now();
+	nout = na * 2.0f + nb * 3.0f - 10.0f; // four temporaries, four passes over memory
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_naive = end - start;
+
+	expr_array ea(size, 1.5f);
+	expr_array eb(size, 2.5f);
+	expr_array eout(size);
+
+	start = std::chrono::high_resolution_clock::now();
+	eout = ea * 2.0f + eb * 3.0f - 10.0f; // no temporaries, one pass over memory
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_expr = end - start;
+
+	float max_diff = 0.0f;
+	for (size_t i = 0; i < size; ++i)
+		max_diff = std::max({ max_diff, std::abs(out[i] - nout[i]), std::abs(out[i] - eout[i]), std::abs(out[i] - out_scalar[i]) });
+
+	std::cout << "Hand loop (compute_original) time: " << time_loop.count() << " seconds\n";
+	std::cout << "Hand loop (scalar) time: " << time_scalar.count() << " seconds\n";
+	std::cout << "Naive operator overloading time: " << time_naive.count() << " seconds\n";
+	std::cout << "Expression template time: " << time_expr.count() << " seconds\n";
+	std::cout << "Max difference from hand loops: " << max_diff << "\n";
 }
 
-void test_fragmentation(size_t iterations, size_t max_block_size) {
-	std::vector<char*> blocks;
-	blocks.reserve(iterations);
+void test_runtime_dispatch() {
+	const size_t size = 10000000;
+	std::vector<int> src(size, 1);
+	std::vector<int> dst(size, 0);
+	std::vector<float> a(size, 1.5f);
+	std::vector<float> b(size, 2.5f);
+	std::vector<float> out(size, 0.0f);
 
-	auto start = std::chrono::high_resolution_clock::now();
+	std::cout << "Selected kernels: " << active_kernels().isa << "\n\n";
 
-	for (size_t i = 0; i < iterations; ++i) {
-		size_t sz = 1 + std::rand() % max_block_size;
-		blocks.push_back(new char[sz]);
-		if (i % 10 == 0 && !blocks.empty()) {
-			size_t idx = std::rand() % blocks.size();
-			delete[] blocks[idx];
-			blocks.erase(blocks.begin() + idx);
+	for (const auto& table : kernel_tables) {
+		if (!table.supported()) {
+			std::cout << table.isa << ": not supported on this CPU\n";
+			continue;
 		}
-	}
 
-	for (auto ptr : blocks) {
-		delete[] ptr;
+		auto start = std::chrono::high_resolution_clock::now();
+		const long long sum = table.sum(src.data(), size);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> time_sum = end - start;
+
+		start = std::chrono::high_resolution_clock::now();
+		table.copy(src.data(), dst.data(), size);
+		end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> time_copy = end - start;
+
+		start = std::chrono::high_resolution_clock::now();
+		table.compute(a.data(), b.data(), out.data(), size);
+		end = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<double> time_compute = end - start;
+
+		const bool ok = sum == static_cast<long long>(size) && dst.back() == 1 && out.back() == 0.5f;
+		std::cout << table.isa << ": sum " << time_sum.count() << " s, copy " << time_copy.count()
+		          << " s, compute " << time_compute.count() << " s" << (ok ? "" : " (WRONG RESULT)") << "\n";
 	}
 
+#if HAS_TARGET_CLONES
+	auto start = std::chrono::high_resolution_clock::now();
+	compute_target_clones(a.data(), b.data(), out.data(), size);
 	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << "target_clones compute time: " << std::chrono::duration<double>(end - start).count() << " s\n";
+#endif
+}
 
-	std::cout << "Fragmentation test done in "
-		<< std::chrono::duration<double>(end - start).count()
-		<< " seconds\n";
+// Branch prediction: the same work done with data-dependent branches, which cost a
+// pipeline flush on every misprediction, and without them via masks and predication.
+long long conditional_sum_branchy(const std::vector<int>& data, int threshold) {
+	long long sum = 0;
+	for (int v : data)
+		if (v >= threshold)
+			sum += v;
+	return sum;
 }
 
-void test_contiguous_allocation(size_t iterations, size_t block_size) {
-	std::vector<char> memory_pool(iterations * block_size);
+long long conditional_sum_branchless(const std::vector<int>& data, int threshold) {
+	long long sum = 0;
+	for (int v : data) {
+		const int mask = -static_cast<int>(v >= threshold); // all ones or all zeros
+		sum += v & mask;
+	}
+	return sum;
+}
 
-	auto start = std::chrono::high_resolution_clock::now();
+size_t filter_branchy(const int* in, int* out, size_t n, int threshold) {
+	size_t count = 0;
+	for (size_t i = 0; i < n; ++i)
+		if (in[i] >= threshold)
+			out[count++] = in[i];
+	return count;
+}
 
-	long long sum = 0;
-	for (size_t i = 0; i < iterations; ++i) {
-		char* block = memory_pool.data() + (i * block_size);
-		for (size_t j = 0; j < block_size; ++j) {
-			block[j] = static_cast<char>(j);
-			sum += block[j];
+// Always stores, only advances the output cursor when the element passes
+size_t filter_branchless(const int* in, int* out, size_t n, int threshold) {
+	size_t count = 0;
+	for (size_t i = 0; i < n; ++i) {
+		out[count] = in[i];
+		count += in[i] >= threshold;
+	}
+	return count;
+}
+
+#if HAS_X86_TARGET_ATTRIBUTES
+// For each 8-bit comparison mask, the lane indices of the passing elements packed to the front
+struct compaction_lut {
+	alignas(32) int32_t lanes[256][8];
+
+	compaction_lut() {
+		for (int mask = 0; mask < 256; ++mask) {
+			int k = 0;
+			for (int lane = 0; lane < 8; ++lane)
+				if (mask & (1 << lane))
+					lanes[mask][k++] = lane;
+			while (k < 8)
+				lanes[mask][k++] = 0;
 		}
 	}
+};
 
-	auto end = std::chrono::high_resolution_clock::now();
+__attribute__((target("avx2")))
+size_t filter_avx2(const int* in, int* out, size_t n, int threshold) {
+	static const compaction_lut lut;
+	const __m256i limit = _mm256_set1_epi32(threshold - 1);
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, limit)));
+		const __m256i idx = _mm256_load_si256(reinterpret_cast<const __m256i*>(lut.lanes[mask]));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count), _mm256_permutevar8x32_epi32(v, idx));
+		count += __builtin_popcount(static_cast<unsigned>(mask));
+	}
+	return count + filter_branchless(in + i, out + count, n - i, threshold);
+}
 
-	std::cout << "Contiguous allocation test done in "
-		<< std::chrono::duration<double>(end - start).count()
-		<< " seconds\n";
+__attribute__((target("avx512f")))
+size_t filter_avx512(const int* in, int* out, size_t n, int threshold) {
+	const __m512i limit = _mm512_set1_epi32(threshold);
+	size_t count = 0;
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const __m512i v = _mm512_loadu_si512(in + i);
+		const __mmask16 mask = _mm512_cmpge_epi32_mask(v, limit);
+		_mm512_mask_compressstoreu_epi32(out + count, mask, v);
+		count += __builtin_popcount(mask);
+	}
+	return count + filter_branchless(in + i, out + count, n - i, threshold);
 }
+#endif
 
-int main()
-{
-	print_header("Performance Optimization Tests");
-	test_optimization();
+size_t lower_bound_branchy(const std::vector<int>& sorted, int key) {
+	size_t lo = 0, hi = sorted.size();
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (sorted[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
 
-	print_header("Inline vs No Inline Tests");
-	test_inline_vs_no_inline();
+// The loop trip count depends only on the size, and the comparison feeds
+// arithmetic (typically a cmov) instead of a jump
+size_t lower_bound_branchless(const std::vector<int>& sorted, int key) {
+	if (sorted.empty())
+		return 0;
+	const int* base = sorted.data();
+	size_t n = sorted.size();
+	while (n > 1) {
+		const size_t half = n / 2;
+		base += (base[half - 1] < key) * half;
+		n -= half;
+	}
+	return (base - sorted.data()) + (*base < key);
+}
 
-	print_header("Loop Unrolling Tests");
-	test_loop_unrolling();
+void test_branch_prediction() {
+	const size_t size = 10000000;
+	const int threshold = 128;
+
+	std::vector<int> unsorted(size);
+	std::mt19937 gen(42);
+	std::uniform_int_distribution<int> dist(0, 255);
+	for (auto& v : unsorted)
+		v = dist(gen);
+	std::vector<int> sorted = unsorted;
+	std::sort(sorted.begin(), sorted.end());
+
+	auto time_sum = [&](const char* label, long long (*fn)(const std::vector<int>&, int), const std::vector<int>& data) {
+		auto start = std::chrono::high_resolution_clock::now();
+		const long long sum = fn(data, threshold);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << label << " time: " << std::chrono::duration<double>(end - start).count()
+		          << " seconds (sum " << sum << ")\n";
+	};
+
+	time_sum("Branchy sum, unsorted", conditional_sum_branchy, unsorted);
+	time_sum("Branchy sum, sorted", conditional_sum_branchy, sorted);
+	time_sum("Branchless sum, unsorted", conditional_sum_branchless, unsorted);
+	time_sum("Branchless sum, sorted", conditional_sum_branchless, sorted);
+	std::cout << "\n";
+
+	std::vector<int> filtered(size + 16);
+	auto time_filter = [&](const char* label, size_t (*fn)(const int*, int*, size_t, int)) {
+		auto start = std::chrono::high_resolution_clock::now();
+		const size_t kept = fn(unsorted.data(), filtered.data(), size, threshold);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << label << " time: " << std::chrono::duration<double>(end - start).count()
+		          << " seconds (kept " << kept << ")\n";
+	};
+
+	time_filter("Branchy filter", filter_branchy);
+	time_filter("Branchless filter", filter_branchless);
+#if HAS_X86_TARGET_ATTRIBUTES
+	if (__builtin_cpu_supports("avx2"))
+		time_filter("AVX2 compaction filter", filter_avx2);
+	if (__builtin_cpu_supports("avx512f"))
+		time_filter("AVX-512 compress filter", filter_avx512);
+#endif
+	std::cout << "\n";
+
+	const size_t table_size = 1 << 20;
+	const size_t queries = 1000000;
+	std::vector<int> table(table_size);
+	for (size_t i = 0; i < table_size; ++i)
+		table[i] = static_cast<int>(2 * i);
+	std::vector<int> keys(queries);
+	std::uniform_int_distribution<int> key_dist(0, static_cast<int>(2 * table_size));
+	for (auto& k : keys)
+		k = key_dist(gen);
+
+	auto time_search = [&](const char* label, size_t (*fn)(const std::vector<int>&, int)) {
+		size_t checksum = 0;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int k : keys)
+			checksum += fn(table, k);
+		auto end = std::chrono::high_resolution_clock::now();
+		std::cout << label << " time: " << std::chrono::duration<double>(end - start).count()
+		          << " seconds (checksum " << checksum << ")\n";
+	};
+
+	time_search("Branchy binary search", lower_bound_branchy);
+	time_search("Branchless binary search", lower_bound_branchless);
+}
 
-	print_header("Short-String Optimization Tests");
+// The per-character, locale-aware versions zen::string used before its lookup-table/SIMD classification
+bool legacy_is_alpha(const std::string& s)     { return !s.empty() && std::all_of(s.begin(), s.end(), [](auto c) { return std::isalpha(c); }); }
+bool legacy_is_digit(const std::string& s)     { return !s.empty() && std::all_of(s.begin(), s.end(), [](auto c) { return std::isdigit(c); }); }
+bool legacy_is_space(const std::string& s)     { return !s.empty() && std::all_of(s.begin(), s.end(), [](auto c) { return std::isspace(c); }); }
+bool legacy_is_printable(const std::string& s) { return std::all_of(s.begin(), s.end(), [](auto c) { return std::isprint(c); }); }
+bool legacy_is_ascii(const std::string& s) {
+	for (char c : s)
+		if (!isascii(c))
+			return false;
+	return true;
+}
+
+void test_string_classification() {
+	const size_t total_bytes = 16 * 1024 * 1024; // processed per measurement, whatever the input size
+
+	struct predicate {
+		const char* name;
+		char fill;
+		bool (*legacy)(const std::string&);
+		bool (zen::string::*current)() const;
+	};
+	const predicate predicates[] = {
+		{ "is_alpha",     'q', legacy_is_alpha,     &zen::string::is_alpha     },
+		{ "is_digit",     '7', legacy_is_digit,     &zen::string::is_digit     },
+		{ "is_space",     ' ', legacy_is_space,     &zen::string::is_space     },
+		{ "is_printable", '~', legacy_is_printable, &zen::string::is_printable },
+		{ "is_ascii",     'A', legacy_is_ascii,     &zen::string::is_ascii     },
+	};
+
+	for (const auto& p : predicates) {
+		for (size_t size : { size_t(1024), size_t(64 * 1024), size_t(1024 * 1024) }) {
+			const zen::string s(std::string(size, p.fill));
+			const size_t iterations = total_bytes / size;
+
+			bool agree = true;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < iterations; ++i)
+				agree &= p.legacy(s);
+			auto end = std::chrono::high_resolution_clock::now();
+			std::chrono::duration<double> time_legacy = end - start;
+
+			start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < iterations; ++i)
+				agree &= (s.*p.current)();
+			end = std::chrono::high_resolution_clock::now();
+			std::chrono::duration<double> time_current = end - start;
+
+			// A single offending char at the very end must flip both to false
+			zen::string bad = s;
+			bad.back() = '\x80';
+			agree &= !p.legacy(bad) && !(bad.*p.current)();
+
+			std::cout << std::left << std::setfill(' ') << std::setw(13) << p.name << std::right << std::setw(5)
+			          << size / 1024 << " KB: std::is* " << time_legacy.count() << " s, table/SIMD "
+			          << time_current.count() << " s" << (agree ? "" : " (RESULTS DIFFER)") << "\n";
+		}
+	}
+}
+
+// The char-by-char versions zen::string used before its vectorized ASCII fast paths
+void legacy_to_lower(std::string& s) {
+	for (auto& c : s)
+		if (std::isalpha(c) && std::isupper(c))
+			c = static_cast<char>(std::tolower(c));
+}
+
+void legacy_to_upper(std::string& s) {
+	for (auto& c : s)
+		if (std::isalpha(c) && std::islower(c))
+			c = static_cast<char>(std::toupper(c));
+}
+
+void legacy_swapcase(std::string& s) {
+	for (auto& c : s)
+		if (std::isalpha(c))
+			c = std::islower(c) ? static_cast<char>(std::toupper(c)) : static_cast<char>(std::tolower(c));
+}
+
+void legacy_capitalize(std::string& s) {
+	if (s.empty())
+		return;
+	if (std::isalpha(s.front()) && std::islower(s.front()))
+		s.front() = static_cast<char>(std::toupper(s.front()));
+	for (size_t i = 1; i < s.size(); ++i)
+		if (std::isalpha(s[i]) && std::isupper(s[i]))
+			s[i] = static_cast<char>(std::tolower(s[i]));
+}
+
+void test_case_conversion() {
+	const size_t size = 8 * 1024 * 1024;
+
+	// Header-like ASCII text, and the same text with a non-ASCII byte every 1 KB
+	const std::string line = "Content-Type: Text/HTML; Charset=UTF-8\r\nX-Request-Id: 5F3A-77b1\r\n";
+	std::string ascii;
+	while (ascii.size() < size)
+		ascii += line;
+	std::string mixed = ascii;
+	for (size_t i = 0; i < mixed.size(); i += 1024)
+		mixed[i] = '\xE9';
+
+	struct conversion {
+		const char* name;
+		void (*legacy)(std::string&);
+		zen::string& (*current)(zen::string&);
+	};
+	const conversion conversions[] = {
+		{ "to_lower",   legacy_to_lower,   [](zen::string& s) -> zen::string& { return s.to_lower();   } },
+		{ "to_upper",   legacy_to_upper,   [](zen::string& s) -> zen::string& { return s.to_upper();   } },
+		{ "swapcase",   legacy_swapcase,   [](zen::string& s) -> zen::string& { return s.swapcase();   } },
+		{ "capitalize", legacy_capitalize, [](zen::string& s) -> zen::string& { return s.capitalize(); } },
+	};
+
+	for (const auto& c : conversions) {
+		for (const std::string* input : { &ascii, &mixed }) {
+			std::string expected = *input;
+			auto start = std::chrono::high_resolution_clock::now();
+			c.legacy(expected);
+			auto end = std::chrono::high_resolution_clock::now();
+			std::chrono::duration<double> time_legacy = end - start;
+
+			zen::string actual(*input);
+			start = std::chrono::high_resolution_clock::now();
+			c.current(actual);
+			end = std::chrono::high_resolution_clock::now();
+			std::chrono::duration<double> time_current = end - start;
+
+			std::cout << std::left << std::setfill(' ') << std::setw(11) << c.name << std::setw(7)
+			          << (input == &ascii ? "ascii" : "mixed") << std::right
+			          << "scalar: " << time_legacy.count() << " s, vectorized: " << time_current.count() << " s"
+			          << (expected == actual ? "" : " (RESULTS DIFFER)") << "\n";
+		}
+	}
+}
+
+// The in-place version zen::string::replace_all used before: every match shifts the whole tail
+void legacy_replace_all(std::string& s, const std::string& search, const std::string& replacement) {
+	size_t pos = 0;
+	while ((pos = s.find(search, pos)) != std::string::npos) {
+		s.replace(pos, search.length(), replacement);
+		pos += replacement.length();
+	}
+}
+
+void test_replace_all() {
+	// A template with a placeholder every 16 bytes: the in-place version is quadratic here
+	const size_t size = 256 * 1024;
+	std::string text;
+	while (text.size() < size)
+		text += "user={{name}}; ";
+
+	std::string expected = text;
+	auto start = std::chrono::high_resolution_clock::now();
+	legacy_replace_all(expected, "{{name}}", "Ada Lovelace");
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_legacy = end - start;
+
+	zen::string actual(text);
+	start = std::chrono::high_resolution_clock::now();
+	actual.replace_all("{{name}}", "Ada Lovelace");
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_two_pass = end - start;
+
+	std::cout << "In-place replace_all time: " << time_legacy.count() << " seconds\n";
+	std::cout << "Two-pass replace_all time: " << time_two_pass.count() << " seconds"
+	          << (expected == actual ? "" : " (RESULTS DIFFER)") << "\n\n";
+
+	// Many needles over a larger log-like text: one replace_all per needle vs a single Aho-Corasick scan
+	const size_t log_size = 4 * 1024 * 1024;
+	std::string log;
+	while (log.size() < log_size)
+		log += "<td class=\"x\">a & b</td> ERROR: 'disk' WARN: \"cpu\" INFO: ok\n";
+
+	const std::vector<std::pair<std::string, std::string>> replacements = {
+		{ "&", "&amp;" }, { "<", "&lt;" }, { ">", "&gt;" }, { "\"", "&quot;" }, { "'", "&#39;" },
+		{ "ERROR", "E" }, { "WARN", "W" }, { "INFO", "I" }, { "DEBUG", "D" }, { "TRACE", "T" },
+	};
+
+	zen::string sequential(log);
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& [search, replacement] : replacements)
+		sequential.replace_all(search, replacement);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_sequential = end - start;
+
+	zen::string multi(log);
+	start = std::chrono::high_resolution_clock::now();
+	multi.replace_all(replacements);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_multi = end - start;
+
+	std::cout << "Sequential replace_all (" << replacements.size() << " needles) time: " << time_sequential.count() << " seconds\n";
+	std::cout << "Aho-Corasick replace_all time: " << time_multi.count() << " seconds"
+	          << (sequential == multi ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_split_views() {
+	const size_t size = 100 * 1024 * 1024;
+	std::string log;
+	log.reserve(size + 128);
+	for (int i = 0; log.size() < size; ++i)
+		log += "2024-05-01 12:00:" + std::to_string(i % 60) + " INFO worker=" + std::to_string(i % 97) + " request served in 12ms\n";
+	const zen::string text(log);
+
+	// The getline-based version zen::string::split_lines used before
+	size_t legacy_lines = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::vector<zen::string> legacy;
+		std::istringstream stream(text);
+		for (std::string line; std::getline(stream, line); )
+			legacy.push_back(line);
+		legacy_lines = legacy.size();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_legacy = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	const std::vector<zen::string> owning = text.split_lines();
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_owning = end - start;
+
+	size_t lines = 0, bytes = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (std::string_view line : text.split_lines_view()) {
+		++lines;
+		bytes += line.size();
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_view = end - start;
+
+	size_t fields = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (std::string_view field : text.split_view(" "))
+		fields += !field.empty();
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_fields = end - start;
+
+	const bool agree = legacy_lines == lines && owning.size() == lines;
+	std::cout << "getline split_lines time: " << time_legacy.count() << " seconds\n";
+	std::cout << "Owning split_lines time: " << time_owning.count() << " seconds\n";
+	std::cout << "split_lines_view time: " << time_view.count() << " seconds (" << lines << " lines, "
+	          << bytes << " bytes)" << (agree ? "" : " (RESULTS DIFFER)") << "\n";
+	std::cout << "split_view(\" \") time: " << time_fields.count() << " seconds (" << fields << " fields)\n";
+}
+
+// The version zen::string::extract_email used before: compiles the pattern and copies the string on every call
+std::string legacy_extract_email(const std::string& s) {
+	const std::regex regex_pattern(R"((\b[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,}\b))");
+	std::smatch match;
+	std::string in(s.begin(), s.end());
+	if (std::regex_search(in, match, regex_pattern))
+		return std::string(s.data() + match.position(0), match.length(0));
+	return "";
+}
+
+void test_regex_cache() {
+	const size_t count = 2000;
+	std::vector<zen::string> lines;
+	lines.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		lines.emplace_back("2024-05-01 12:00 INFO login ok for user" + std::to_string(i % 1000) + "@example.com from 10.0.0." + std::to_string(i % 256));
+
+	size_t legacy_found = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines)
+		legacy_found += !legacy_extract_email(line).empty();
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_legacy = end - start;
+
+	size_t found = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines)
+		found += !line.extract_email().empty();
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_cached = end - start;
+
+	std::cout << "Compile-per-call extract_email time: " << time_legacy.count() << " seconds\n";
+	std::cout << "Cached extract_email time: " << time_cached.count() << " seconds (" << found << " of " << count << " lines)"
+	          << (legacy_found == found ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_pattern_scanners() {
+	const size_t count = 2000;
+	std::vector<zen::string> lines;
+	lines.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		lines.emplace_back("2024/05/" + std::to_string(1 + i % 28) + " INFO user" + std::to_string(i % 1000) + "@example.com fetched https://example.com/pkg/"
+		                   + std::to_string(i) + " v1.2." + std::to_string(i % 10) + ".0 #release from build.tar.gz");
+
+	// The same patterns the extract_* methods used, each compiled once
+	const std::regex patterns[] = {
+		std::regex(R"((\d+)\.(\d+)\.(\d+)\.(\d+))"),
+		std::regex(R"((\d+\/\d+\/\d+))"),
+		std::regex(R"((\b[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\.[A-Za-z]{2,}\b))"),
+		std::regex(R"((https?://[^\s]+))"),
+		std::regex(R"((#\w+))"),
+		std::regex(R"((\.\w+$))"),
+	};
+
+	std::vector<zen::string> expected;
+	expected.reserve(count * 6);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines)
+		for (const auto& pattern : patterns)
+			expected.push_back(line.extract_pattern(pattern));
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_regex = end - start;
+
+	std::vector<zen::string> actual;
+	actual.reserve(count * 6);
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines) {
+		actual.push_back(line.extract_version());
+		actual.push_back(line.extract_date());
+		actual.push_back(line.extract_email());
+		actual.push_back(line.extract_url());
+		actual.push_back(line.extract_hashtag());
+		actual.push_back(line.extract_extension());
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_scanners = end - start;
+
+	std::cout << "std::regex extract_* time: " << time_regex.count() << " seconds ("
+	          << count / time_regex.count() << " lines/s)\n";
+	std::cout << "Hand-written extract_* time: " << time_scanners.count() << " seconds ("
+	          << count / time_scanners.count() << " lines/s)" << (expected == actual ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// Random short strings built from the characters the patterns care about
+	std::mt19937 rng(42);
+	const std::vector<std::string> pieces = { "a", "Z", "0", "7", "_", ".", "@", "/", "#", ":", "-", "%", " ", "\t",
+	                                          "http", "https://", "ex.com", "1.2.3.4", "12/1/2024", ".txt", "\xC3\xA9" };
+	size_t mismatches = 0;
+	const size_t fuzz_count = 5000;
+	for (size_t i = 0; i < fuzz_count; ++i) {
+		std::string text;
+		for (size_t n = rng() % 16; n > 0; --n)
+			text += pieces[rng() % pieces.size()];
+		const zen::string z(text);
+		const zen::string scanned[] = { z.extract_version(), z.extract_date(), z.extract_email(),
+		                                z.extract_url(), z.extract_hashtag(), z.extract_extension() };
+		for (size_t p = 0; p < 6; ++p)
+			mismatches += scanned[p] != z.extract_pattern(patterns[p]);
+	}
+	std::cout << "Fuzzed " << fuzz_count << " random strings against std::regex: " << mismatches << " mismatches\n";
+}
+
+#if ZEN_HAS_CT_REGEX
+void test_compile_time_regex() {
+	// Only match() is used with this pattern, so the reverse DFA of search(), which would
+	// need more states than ct_regex allows, is never compiled
+	static_assert(zen::ct_regex<"[ab]{6}a">::match("abababa") && !zen::ct_regex<"[ab]{6}a">::match("abababb"));
+
+	const size_t count = 20000;
+	std::vector<std::string> versions;
+	versions.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		versions.push_back(std::to_string(i % 20) + "." + std::to_string(i % 7) + "." + std::to_string(i % 113) + "." + std::to_string(i));
+
+	size_t matched_runtime = 0;
+	static const std::regex rx_version{R"(\d+\.\d+\.\d+\.\d+)"};
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto& v : versions)
+		matched_runtime += std::regex_match(v, rx_version);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_runtime = end - start;
+
+	size_t matched_compile_time = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& v : versions)
+		matched_compile_time += zen::ct_regex<R"(\d+\.\d+\.\d+\.\d+)">::match(v);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_compile_time = end - start;
+
+	std::cout << "std::regex_match time: " << time_runtime.count() << " seconds\n";
+	std::cout << "zen::ct_regex::match time: " << time_compile_time.count() << " seconds"
+	          << (matched_runtime == matched_compile_time ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// search() and extract_pattern<>() against std::regex_search on log lines, a third of them
+	// without a date. For this pattern the leftmost-longest match is also the one std::regex finds.
+	std::vector<zen::string> lines;
+	lines.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+		lines.push_back(i % 3 == 0 ? "worker " + std::to_string(i) + " idle, nothing to report"
+		                           : "job " + std::to_string(i) + " finished on " + std::to_string(1 + i % 12) + "/" + std::to_string(1 + i % 28) + "/2024 in " + std::to_string(i % 97) + " ms");
+
+	static const std::regex rx_date{R"(\d+/\d+/\d+)"};
+	std::vector<std::string> found_runtime;
+	found_runtime.reserve(count);
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines) {
+		std::smatch m;
+		found_runtime.push_back(std::regex_search(line, m, rx_date) ? m.str() : std::string());
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_search_runtime = end - start;
+
+	std::vector<zen::string> found_compile_time;
+	found_compile_time.reserve(count);
+	start = std::chrono::high_resolution_clock::now();
+	for (const auto& line : lines)
+		found_compile_time.push_back(line.extract_pattern<R"(\d+/\d+/\d+)">());
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_search_compile_time = end - start;
+
+	bool same_search = true;
+	for (size_t i = 0; i < count && same_search; ++i) {
+		const auto match = zen::ct_regex<R"(\d+/\d+/\d+)">::search(lines[i]);
+		same_search = found_runtime[i] == std::string(found_compile_time[i]) && found_runtime[i] == std::string(match.value_or(""));
+	}
+
+	std::cout << "std::regex_search time: " << time_search_runtime.count() << " seconds\n";
+	std::cout << "zen::string::extract_pattern<> time: " << time_search_compile_time.count() << " seconds"
+	          << (same_search ? "" : " (RESULTS DIFFER)") << "\n";
+}
+#endif
+
+// The std::regex-based zen::version string constructor used before
+zen::version legacy_parse_version(const std::string& text) {
+	static const std::regex rx_version{R"((\d+)\.(\d+)\.(\d+)\.(\d+))"};
+	std::smatch sm;
+	if (!std::regex_match(text, sm, rx_version))
+		throw std::invalid_argument("BAD VERSION");
+	return zen::version(std::stoi(sm[1]), std::stoi(sm[2]), std::stoi(sm[3]), std::stoi(sm[4]));
+}
+
+void test_version_parsing() {
+	// A manifest of 10M version strings, one per line
+	const size_t count = 10'000'000;
+	std::string manifest(count * (zen::version::max_chars + 1), '\0');
+
+	auto start = std::chrono::high_resolution_clock::now();
+	char* out = manifest.data();
+	for (size_t i = 0; i < count; ++i) {
+		const zen::version v(static_cast<int>(i % 20), static_cast<int>(i % 7), static_cast<int>(i % 113), static_cast<int>(i));
+		out = v.to_chars(out, manifest.data() + manifest.size()).ptr;
+		*out++ = '\n';
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_format = end - start;
+	manifest.resize(static_cast<size_t>(out - manifest.data()));
+
+	// The ostream-based operator<< used before, on a smaller sample
+	const size_t stream_count = 200'000;
+	std::ostringstream stream;
+	start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < stream_count; ++i)
+		stream << static_cast<int>(i % 20) << '.' << static_cast<int>(i % 7) << '.' << static_cast<int>(i % 113) << '.' << static_cast<int>(i) << '\n';
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_stream = end - start;
+
+	const zen::string text(std::move(manifest));
+	long long sum = 0;
+	size_t parsed = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (std::string_view line : text.split_lines_view()) {
+		if (const auto v = zen::version::try_parse(line)) {
+			sum += v->build();
+			++parsed;
+		}
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_parse = end - start;
+
+	// The regex + std::stoi parse used before, on a smaller sample
+	const size_t regex_count = 20'000;
+	long long regex_sum = 0;
+	size_t line_index = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (std::string_view line : text.split_lines_view()) {
+		if (line_index++ == regex_count)
+			break;
+		regex_sum += legacy_parse_version(std::string(line)).build();
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_regex = end - start;
+
+	// Line i has build number i
+	const auto builds_up_to = [](size_t n) { return static_cast<long long>(n) * static_cast<long long>(n - 1) / 2; };
+	const auto ns_per_op = [](std::chrono::duration<double> t, size_t n) { return t.count() * 1e9 / static_cast<double>(n); };
+	std::cout << "ostream format: " << ns_per_op(time_stream, stream_count) << " ns/version (" << stream_count << " versions)\n";
+	std::cout << "to_chars format: " << ns_per_op(time_format, count) << " ns/version (" << count << " versions, "
+	          << time_format.count() << " seconds)\n";
+	std::cout << "std::regex + std::stoi parse: " << ns_per_op(time_regex, regex_count) << " ns/version (" << regex_count << " versions)"
+	          << (regex_sum == builds_up_to(regex_count) ? "" : " (RESULTS DIFFER)") << "\n";
+	std::cout << "from_chars parse: " << ns_per_op(time_parse, parsed) << " ns/version (" << parsed << " versions, "
+	          << time_parse.count() << " seconds)" << (sum == builds_up_to(count) ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+// The stringstream-per-call zen::to_string used before
+template<class T>
+std::string legacy_to_string(const T& x) {
+	std::stringstream ss;
+	if constexpr (zen::is_string_like<T>()) {
+		return x;
+	} else if constexpr (zen::is_iterable_v<T>) {
+		ss << "[";
+		auto it = std::begin(x);
+		if (it != std::end(x)) {
+			if constexpr (zen::is_string_like<decltype(*it)>())
+				ss << zen::quote(legacy_to_string(*it++));
+			else
+				ss << legacy_to_string(*it++);
+		}
+		for (; it != std::end(x); ++it) {
+			if constexpr (zen::is_string_like<decltype(*it)>())
+				ss << ", " << zen::quote(legacy_to_string(*it));
+			else
+				ss << ", " << legacy_to_string(*it);
+		}
+		ss << "]";
+	} else {
+		ss << x;
+	}
+	return ss.str();
+}
+
+template<class T>
+void run_to_string_variant(const char* name, const T& data) {
+	auto start = std::chrono::high_resolution_clock::now();
+	const std::string expected = legacy_to_string(data);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_legacy = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	const zen::string actual = zen::to_string(data);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_current = end - start;
+
+	// Formatting into a buffer that is reused keeps even the result allocation out of the loop
+	std::string buffer;
+	buffer.reserve(actual.size());
+	start = std::chrono::high_resolution_clock::now();
+	zen::format_into(buffer, data);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_reused = end - start;
+
+	std::cout << std::left << std::setfill(' ') << std::setw(26) << name << std::right
+	          << "stringstream: " << time_legacy.count() << " s, to_string: " << time_current.count()
+	          << " s, format_into reused buffer: " << time_reused.count() << " s"
+	          << (expected == actual && expected == buffer ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_format_into() {
+	std::vector<std::vector<int>> ints(500, std::vector<int>(1000));
+	for (size_t i = 0; i < ints.size(); ++i)
+		for (size_t j = 0; j < ints[i].size(); ++j)
+			ints[i][j] = static_cast<int>(i * 1000 + j) - 250000;
+
+	std::vector<std::vector<double>> doubles(200, std::vector<double>(500));
+	for (size_t i = 0; i < doubles.size(); ++i)
+		for (size_t j = 0; j < doubles[i].size(); ++j)
+			doubles[i][j] = static_cast<double>(i) / 3.0 + static_cast<double>(j) * 1e-3;
+
+	std::vector<std::string> words;
+	for (int i = 0; i < 200000; ++i)
+		words.push_back("item" + std::to_string(i));
+
+	run_to_string_variant("500x1000 ints:", ints);
+	run_to_string_variant("200x500 doubles:", doubles);
+	run_to_string_variant("200K strings:", words);
+
+	zen::fixed_buffer<64> line;
+	zen::format_into(line, "request", 42, "served in", 12.5, "ms");
+	std::cout << "fixed_buffer<64>: " << line.view() << "\n";
+}
+
+void test_async_logging() {
+	const size_t count = 200000;
+	const auto path = std::filesystem::temp_directory_path() / "zen_async_log_test.txt";
+
+	// What zen::log does: one std::endl, and therefore one flush and one system call, per line
+	auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::ofstream out(path);
+		for (size_t i = 0; i < count; ++i)
+			out << "request " << i << " served in " << i % 50 << " ms" << std::endl;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_endl = end - start;
+
+	std::FILE* file = std::fopen(path.string().c_str(), "w");
+	std::chrono::duration<double> time_logging, time_total;
+	start = std::chrono::high_resolution_clock::now();
+	{
+		zen::async_logger logger(file);
+		for (size_t i = 0; i < count; ++i)
+			logger.log("request", i, "served in", i % 50, "ms");
+		time_logging = std::chrono::high_resolution_clock::now() - start;
+	}
+	time_total = std::chrono::high_resolution_clock::now() - start;
+	std::fclose(file);
+	const auto single_thread_size = std::filesystem::file_size(path);
+
+	// Several threads logging at once, each into its own ring
+	const size_t threads = 4;
+	file = std::fopen(path.string().c_str(), "w");
+	std::chrono::duration<double> time_threads;
+	start = std::chrono::high_resolution_clock::now();
+	{
+		zen::async_logger logger(file);
+		std::vector<std::thread> workers;
+		for (size_t t = 0; t < threads; ++t)
+			workers.emplace_back([&logger, t, count, threads] {
+				for (size_t i = t; i < count; i += threads)
+					logger.log("request", i, "served in", i % 50, "ms");
+			});
+		for (auto& worker : workers)
+			worker.join();
+	}
+	time_threads = std::chrono::high_resolution_clock::now() - start;
+	std::fclose(file);
+	const auto multi_thread_size = std::filesystem::file_size(path);
+	std::filesystem::remove(path);
+
+	std::cout << "std::endl per line time: " << time_endl.count() << " seconds (" << count << " lines)\n";
+	std::cout << "async_logger time in log(): " << time_logging.count() << " seconds, until written: " << time_total.count() << " seconds\n";
+	std::cout << "async_logger " << threads << " threads time: " << time_threads.count() << " seconds"
+	          << (single_thread_size == multi_thread_size ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+template<class T>
+void run_serialization_variant(const char* name, const T& data) {
+	auto start = std::chrono::high_resolution_clock::now();
+	const zen::string text = zen::to_string(data);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_text = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	const std::vector<char> bytes = zen::to_bytes(data);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_write = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	const T copy = zen::from_bytes<T>(bytes);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_read = end - start;
+
+	const auto mb_per_s = [](size_t bytes, std::chrono::duration<double> t) { return static_cast<double>(bytes) / 1e6 / t.count(); };
+	std::cout << name << "\n"
+	          << "  text: " << time_text.count() << " s (" << text.size() << " bytes)\n"
+	          << "  binary write: " << time_write.count() << " s (" << bytes.size() << " bytes, " << mb_per_s(bytes.size(), time_write) << " MB/s)\n"
+	          << "  binary read: " << time_read.count() << " s (" << mb_per_s(bytes.size(), time_read) << " MB/s)"
+	          << (copy == data ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_binary_serialization() {
+	zen::vector<double> doubles(2'000'000);
+	for (size_t i = 0; i < doubles.size(); ++i)
+		doubles[i] = static_cast<double>(i) * 0.25;
+
+	zen::map<zen::string, int> counters;
+	for (int i = 0; i < 100'000; ++i)
+		counters.emplace("key" + std::to_string(i), i);
+
+	std::vector<std::tuple<int, double, std::string>> records;
+	for (int i = 0; i < 100'000; ++i)
+		records.emplace_back(i, i * 0.5, "user" + std::to_string(i % 1000));
+
+	std::vector<zen::point3d> points;
+	for (int i = 0; i < 500'000; ++i)
+		points.emplace_back(i, i * 2.0, i * 3.0);
+
+	run_serialization_variant("zen::vector<double>, 2M elements:", doubles);
+	run_serialization_variant("zen::map<zen::string, int>, 100K entries:", counters);
+	run_serialization_variant("std::vector<std::tuple<int, double, std::string>>, 100K records:", records);
+
+	// zen::point3d has no text form, so only the binary path is timed
+	auto start = std::chrono::high_resolution_clock::now();
+	const std::vector<char> bytes = zen::to_bytes(points);
+	const auto copy = zen::from_bytes<std::vector<zen::point3d>>(bytes);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_points = end - start;
+	std::cout << "std::vector<zen::point3d>, 500K points:\n  binary round trip: " << time_points.count() << " s (" << bytes.size() << " bytes)"
+	          << (copy.size() == points.size() && copy.back().z() == points.back().z() ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// A view is written as the characters it refers to, so it reads back as an owning string
+	const std::string_view view = "zen::binary_writer";
+	const auto text = zen::from_bytes<std::string>(zen::to_bytes(view));
+	std::cout << "std::string_view round trip: \"" << text << "\"" << (text == view ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+struct hash_map_timings {
+	double insert = 0, find_hit = 0, find_miss = 0, erase = 0; // ns per operation
+	size_t checksum = 0;
+};
+
+template<class Map>
+hash_map_timings run_hash_map_variant(const std::vector<uint64_t>& keys, const std::vector<uint64_t>& missing, size_t repeats) {
+	hash_map_timings t;
+	const double ops = static_cast<double>(keys.size() * repeats);
+	const auto ns = [ops](std::chrono::high_resolution_clock::time_point start) {
+		return std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / ops;
+	};
+
+	for (size_t r = 0; r < repeats; ++r) {
+		Map map;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (const uint64_t k : keys)
+			map.emplace(k, k);
+		t.insert += ns(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (const uint64_t k : keys)
+			t.checksum += map.find(k)->second;
+		t.find_hit += ns(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (const uint64_t k : missing)
+			t.checksum += map.find(k) == map.end();
+		t.find_miss += ns(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (const uint64_t k : keys)
+			t.checksum += map.erase(k);
+		t.erase += ns(start);
+	}
+	return t;
+}
+
+void test_flat_hash_map() {
+	std::mt19937_64 rng(7);
+	for (const size_t n : { size_t(1'000), size_t(10'000), size_t(100'000), size_t(1'000'000) }) {
+		std::vector<uint64_t> keys(n), missing(n);
+		for (auto& k : keys)
+			k = rng() | 1; // odd keys are present, even keys are missing
+		for (auto& k : missing)
+			k = rng() & ~uint64_t(1);
+
+		const size_t repeats = std::max<size_t>(1, 100'000 / n); // keep small tables measurable
+		const auto node  = run_hash_map_variant<zen::unordered_map<uint64_t, uint64_t>>(keys, missing, repeats);
+		const auto flat  = run_hash_map_variant<zen::flat_hash_map<uint64_t, uint64_t>>(keys, missing, repeats);
+
+		std::cout << std::setfill(' ') << std::setw(8) << n << " keys (ns/op, unordered_map vs flat_hash_map): "
+		          << "insert " << node.insert << " vs " << flat.insert
+		          << ", find " << node.find_hit << " vs " << flat.find_hit
+		          << ", miss " << node.find_miss << " vs " << flat.find_miss
+		          << ", erase " << node.erase << " vs " << flat.erase
+		          << (node.checksum == flat.checksum ? "" : " (RESULTS DIFFER)") << "\n";
+	}
+}
+
+template<class Map, class Query>
+double run_lookup_variant(const Map& map, const std::vector<std::string_view>& queries, size_t repeats, Query query, size_t& hits) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t r = 0; r < repeats; ++r)
+		for (const std::string_view q : queries)
+			hits += query(map, q);
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_transparent_lookup() {
+	// Header names as they come out of a parsed request: views into the request buffer,
+	// most of them too long for the short-string buffer, so a temporary key allocates
+	const std::vector<std::string> names = {
+		"accept-encoding", "authorization", "cache-control", "content-length", "content-type",
+		"host", "if-modified-since", "user-agent", "x-forwarded-for", "x-request-id",
+		"access-control-request-headers", "strict-transport-security", "x-correlation-identifier"
+	};
+	const zen::string request = "x-forwarded-for content-type x-correlation-identifier x-unknown-header-name "
+	                            "access-control-request-headers host if-modified-since x-missing";
+	std::vector<std::string_view> queries;
+	for (const std::string_view q : request.split_view(" "))
+		queries.push_back(q);
+
+	std::map<std::string, std::string>           std_tree;
+	std::unordered_map<std::string, std::string> std_hash;
+	zen::keyval                                  zen_tree;
+	zen::unordered_map<zen::string, zen::string> zen_hash;
+	for (const auto& n : names) {
+		std_tree[n] = zen_tree[n] = "value";
+		std_hash[n] = zen_hash[n] = "value";
+	}
+
+	const size_t repeats = 100'000;
+	size_t std_hits = 0, zen_hits = 0;
+	const auto by_copy = [](const auto& map, std::string_view q) { return map.count(std::string(q)); };
+	const auto by_view = [](const auto& map, std::string_view q) { return map.count(q); };
+
+	const double std_tree_time = run_lookup_variant(std_tree, queries, repeats, by_copy, std_hits);
+	const double zen_tree_time = run_lookup_variant(zen_tree, queries, repeats, by_view, zen_hits);
+	const double std_hash_time = run_lookup_variant(std_hash, queries, repeats, by_copy, std_hits);
+	const double zen_hash_time = run_lookup_variant(zen_hash, queries, repeats, by_view, zen_hits);
+
+	const size_t lookups = queries.size() * repeats;
+	std::cout << "Ordered map, " << lookups << " string_view lookups:\n"
+	          << "  std::map<std::string, ...> with a temporary key: " << std_tree_time << " seconds\n"
+	          << "  zen::keyval, transparent std::less<>:            " << zen_tree_time << " seconds\n";
+	std::cout << "Hash map, " << lookups << " string_view lookups:\n"
+	          << "  std::unordered_map<std::string, ...> with a temporary key: " << std_hash_time << " seconds\n"
+	          << "  zen::unordered_map<zen::string, ...>, zen::string_hash:    " << zen_hash_time << " seconds"
+	          << (std_hits == zen_hits ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+struct bucket_stats {
+	double empty_pct = 0; // an ideal hash leaves e^-1 = 36.8% of the buckets empty at load 1
+	size_t max_load  = 0;
+};
+
+// Spreads the hashes over a power-of-two table by their low bits, the way zen::flat_hash_map
+// and most open-addressing tables pick a bucket
+template<class Keys, class Hash>
+bucket_stats low_bit_buckets(const Keys& keys, Hash hash) {
+	std::vector<uint32_t> buckets(keys.size());
+	for (const auto& k : keys)
+		++buckets[hash(k) & (buckets.size() - 1)];
+	bucket_stats s;
+	s.empty_pct = 100.0 * static_cast<double>(std::count(buckets.begin(), buckets.end(), 0u)) / static_cast<double>(buckets.size());
+	s.max_load  = *std::max_element(buckets.begin(), buckets.end());
+	return s;
+}
+
+template<class Hash>
+double hash_throughput(const std::string& data, size_t len, Hash hash, volatile uint64_t& sink) {
+	const size_t total = 64 << 20;
+	uint64_t acc = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t done = 0, offset = 0; done < total; done += len, offset = (offset + 1) & 63)
+		acc += hash(std::string_view(data.data() + offset, len));
+	auto end = std::chrono::high_resolution_clock::now();
+	sink = acc;
+	return static_cast<double>(total) / 1e9 / std::chrono::duration<double>(end - start).count();
+}
+
+template<class Hash>
+double dedup_time(const std::vector<std::string_view>& stream, size_t& distinct) {
+	std::unordered_set<std::string_view, Hash> seen;
+	seen.reserve(stream.size() / 2);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const auto s : stream)
+		seen.insert(s);
+	auto end = std::chrono::high_resolution_clock::now();
+	distinct = seen.size();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_fast_hash() {
+	const std::hash<std::string_view> std_hash;
+	const zen::string_hash            wy_hash;
+
+	std::string data(4096 + 64, '\0');
+	std::mt19937_64 rng(11);
+	for (auto& c : data)
+		c = static_cast<char>(rng());
+
+	volatile uint64_t sink = 0;
+	std::cout << "Throughput (GB/s, std::hash vs zen::wyhash):";
+	for (const size_t len : { size_t(8), size_t(32), size_t(256), size_t(4096) })
+		std::cout << " " << len << " B: " << hash_throughput(data, len, std_hash, sink) << " vs " << hash_throughput(data, len, wy_hash, sink) << ";";
+	std::cout << "\n";
+
+	// Keys that differ only in a few characters, or integers that share their low bits
+	const size_t n = 1 << 20;
+	std::vector<std::string> names(n);
+	std::vector<uint64_t>    ids(n);
+	for (size_t i = 0; i < n; ++i) {
+		names[i] = "user:" + std::to_string(i);
+		ids[i]   = static_cast<uint64_t>(i) << 12;
+	}
+	const auto names_std = low_bit_buckets(names, [&](const std::string& s) { return std_hash(s); });
+	const auto names_wy  = low_bit_buckets(names, [&](const std::string& s) { return wy_hash(s); });
+	const auto ids_std   = low_bit_buckets(ids, std::hash<uint64_t>());
+	const auto ids_wy    = low_bit_buckets(ids, zen::fast_hash<uint64_t>());
+	std::cout << "Bucket spread, 1M keys in 1M buckets (empty %, longest chain; ideal 36.8%):\n"
+	          << "  \"user:<i>\" strings, std::hash:          " << names_std.empty_pct << "%, " << names_std.max_load << "\n"
+	          << "  \"user:<i>\" strings, zen::string_hash:   " << names_wy.empty_pct  << "%, " << names_wy.max_load  << "\n"
+	          << "  i << 12 integers, std::hash:            " << ids_std.empty_pct   << "%, " << ids_std.max_load   << "\n"
+	          << "  i << 12 integers, zen::fast_hash:       " << ids_wy.empty_pct    << "%, " << ids_wy.max_load    << "\n";
+
+	// Dedup: every name shows up twice, only the hasher differs between the two sets
+	std::vector<std::string_view> stream;
+	stream.reserve(2 * n);
+	for (int pass = 0; pass < 2; ++pass)
+		for (const auto& s : names)
+			stream.push_back(s);
+	std::shuffle(stream.begin(), stream.end(), rng);
+
+	size_t distinct_std = 0, distinct_wy = 0;
+	double time_std = 1e9, time_wy = 1e9;
+	for (int round = 0; round < 2; ++round) { // best of two, alternating, as node allocation makes this noisy
+		time_std = std::min(time_std, dedup_time<std::hash<std::string_view>>(stream, distinct_std));
+		time_wy  = std::min(time_wy,  dedup_time<zen::string_hash>(stream, distinct_wy));
+	}
+
+	std::cout << "Dedup of 2M strings, std::hash: " << time_std << " seconds\n"
+	          << "Dedup of 2M strings, zen::string_hash: " << time_wy << " seconds"
+	          << (distinct_std == distinct_wy ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+struct sorted_container_timings {
+	double build = 0;  // seconds
+	double lookup = 0; // ns per lookup
+	size_t hits = 0;
+};
+
+template<class Container, class Build>
+sorted_container_timings run_sorted_container_variant(Build build, const std::vector<uint64_t>& queries, size_t repeats) {
+	sorted_container_timings t;
+	auto start = std::chrono::high_resolution_clock::now();
+	const Container c = build();
+	auto end = std::chrono::high_resolution_clock::now();
+	t.build = std::chrono::duration<double>(end - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	for (size_t r = 0; r < repeats; ++r)
+		for (const uint64_t q : queries)
+			t.hits += c.contains(q);
+	end = std::chrono::high_resolution_clock::now();
+	t.lookup = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(queries.size() * repeats);
+	return t;
+}
+
+void test_flat_containers() {
+	std::mt19937_64 rng(5);
+	for (const size_t n : { size_t(1'000), size_t(32'000), size_t(1'000'000) }) {
+		std::vector<std::pair<uint64_t, uint64_t>> pairs(n);
+		std::vector<uint64_t> keys(n), queries(n);
+		for (size_t i = 0; i < n; ++i) {
+			keys[i]  = rng();
+			pairs[i] = { keys[i], i };
+		}
+		for (size_t i = 0; i < n; ++i) // half hits, half misses
+			queries[i] = i % 2 ? keys[rng() % n] : rng();
+
+		const size_t repeats = std::max<size_t>(1, 1'000'000 / n);
+		const auto tree_map = run_sorted_container_variant<zen::map<uint64_t, uint64_t>>(
+			[&] { zen::map<uint64_t, uint64_t> m; for (const auto& p : pairs) m.insert(p); return m; }, queries, repeats);
+		const auto flat_map = run_sorted_container_variant<zen::flat_map<uint64_t, uint64_t>>(
+			[&] { return zen::flat_map<uint64_t, uint64_t>(pairs.begin(), pairs.end()); }, queries, repeats);
+		const auto tree_set = run_sorted_container_variant<zen::set<uint64_t>>(
+			[&] { return zen::set<uint64_t>(keys.begin(), keys.end()); }, queries, repeats);
+		const auto flat_set = run_sorted_container_variant<zen::flat_set<uint64_t>>(
+			[&] { return zen::flat_set<uint64_t>(keys.begin(), keys.end()); }, queries, repeats);
+
+		std::cout << std::setfill(' ') << std::setw(8) << n << " keys (tree vs flat): "
+		          << "map build " << tree_map.build << " vs " << flat_map.build << " s, lookup " << tree_map.lookup << " vs " << flat_map.lookup << " ns; "
+		          << "set build " << tree_set.build << " vs " << flat_set.build << " s, lookup " << tree_set.lookup << " vs " << flat_set.lookup << " ns"
+		          << (tree_map.hits == flat_map.hits && tree_set.hits == flat_set.hits ? "" : " (RESULTS DIFFER)") << "\n";
+	}
+}
+
+// Builds and drops `count` short-lived vectors of 2 to max_size elements, like the
+// per-token or per-edge scratch vectors of a parser or a graph walk
+template<class Vec>
+double run_small_collection_variant(size_t count, size_t max_size, uint64_t& checksum) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < count; ++i) {
+		Vec v;
+		const size_t n = 2 + i % (max_size - 1);
+		for (size_t j = 0; j < n; ++j)
+			v.push_back(static_cast<int>(i + j));
+		for (const int x : v)
+			checksum += static_cast<uint64_t>(x);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_small_vector() {
+	const size_t count = 2'000'000;
+	for (const size_t max_size : { size_t(8), size_t(16) }) {
+		uint64_t heap_sum = 0, small_sum = 0;
+		const double heap_time  = run_small_collection_variant<zen::vector<int>>(count, max_size, heap_sum);
+		const double small_time = run_small_collection_variant<zen::small_vector<int, 8>>(count, max_size, small_sum);
+		std::cout << count << " vectors of 2-" << max_size << " ints" << (max_size > 8 ? " (some spill to the heap)" : "") << ":\n"
+		          << "  zen::vector<int>:          " << heap_time  << " seconds\n"
+		          << "  zen::small_vector<int, 8>: " << small_time << " seconds"
+		          << (heap_sum == small_sum ? "" : " (RESULTS DIFFER)") << "\n";
+	}
+}
+
+template<class T>
+void run_linear_search_variant(const char* name, zen::vector<T>& v, const T present, const T missing) {
+	const int repeats = 10;
+	size_t scalar_found = 0, simd_found = 0, scalar_count = 0, simd_count = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		v[0] = static_cast<T>(r); // a store per round keeps the optimizer from hoisting the searches out of the loops
+		scalar_found += (std::find(v.begin(), v.end(), missing) != v.end()) + (std::find(v.begin(), v.end(), present) != v.end());
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_scalar_find = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		v[0] = static_cast<T>(r);
+		simd_found += v.contains(missing) + v.contains(present);
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_simd_find = end - start;
+
+	// The element-by-element loop zen::count used to run
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		v[0] = static_cast<T>(r);
+		for (auto it = v.begin(); it != v.end(); ++it)
+			scalar_count += *it == present;
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_scalar_count = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int r = 0; r < repeats; ++r) {
+		v[0] = static_cast<T>(r);
+		simd_count += zen::count(v, present);
+	}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_simd_count = end - start;
+
+	std::cout << name << ", " << v.size() << " elements, " << repeats << " rounds:\n"
+	          << "  std::find:             " << time_scalar_find.count()  << " seconds\n"
+	          << "  zen::vector::contains: " << time_simd_find.count()    << " seconds\n"
+	          << "  scalar count loop:     " << time_scalar_count.count() << " seconds\n"
+	          << "  zen::count:            " << time_simd_count.count()   << " seconds"
+	          << (scalar_found == simd_found && scalar_count == simd_count ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_simd_linear_search() {
+	const size_t n = 10'000'000;
+	std::mt19937 rng(17);
+	zen::vector<int>   ints(n);
+	zen::vector<float> floats(n);
+	for (size_t i = 0; i < n; ++i) {
+		ints[i]   = static_cast<int>(rng() % 1'000'000);
+		floats[i] = static_cast<float>(ints[i]) * 0.5f;
+	}
+	// The present value sits near the end, so both searches scan (almost) everything
+	ints[n - 3]   = -1;
+	floats[n - 3] = -1.0f;
+
+	run_linear_search_variant("int",   ints,   -1,    -2);
+	run_linear_search_variant("float", floats, -1.0f, -2.0f);
+}
+
+// The mutex-guarded zen::queue that the lock-free queues replace as a work queue
+class locked_queue {
+public:
+	bool try_push(int x) { std::lock_guard<std::mutex> lock(mutex_); queue_.push(x); return true; }
+
+	bool try_pop(int& out)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (queue_.is_empty())
+			return false;
+		out = queue_.front();
+		queue_.pop();
+		return true;
+	}
+
+private:
+	std::mutex      mutex_;
+	zen::queue<int> queue_;
+};
+
+// Half the threads push `items` ints between them, the other half pop them all;
+// returns the seconds taken and adds what was popped to `checksum`
+template<class Queue>
+double run_queue_variant(Queue& q, size_t threads, size_t items, uint64_t& checksum) {
+	const size_t producers = std::max<size_t>(1, threads / 2), consumers = std::max<size_t>(1, threads - producers);
+	std::atomic<size_t> left(items);
+	std::atomic<uint64_t> sum(0);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	std::vector<std::thread> workers;
+	for (size_t p = 0; p < producers; ++p)
+		workers.emplace_back([&q, p, producers, items] {
+			for (size_t i = p; i < items; i += producers)
+				while (!q.try_push(static_cast<int>(i)))
+					std::this_thread::yield();
+		});
+	for (size_t c = 0; c < consumers; ++c)
+		workers.emplace_back([&q, &left, &sum] {
+			uint64_t local = 0;
+			int x;
+			while (left.load(std::memory_order_relaxed) > 0) {
+				if (q.try_pop(x)) {
+					local += static_cast<uint64_t>(x);
+					left.fetch_sub(1, std::memory_order_relaxed);
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+			sum += local;
+		});
+	for (auto& w : workers)
+		w.join();
+	auto end = std::chrono::high_resolution_clock::now();
+
+	checksum += sum;
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_concurrent_queues() {
+	const size_t items = 1'000'000;
+	uint64_t locked_sum = 0, lockfree_sum = 0;
+
+	{
+		locked_queue          locked;
+		zen::spsc_queue<int>  spsc(1024);
+		const double time_locked = run_queue_variant(locked, 2, items, locked_sum);
+		const double time_spsc   = run_queue_variant(spsc,   2, items, lockfree_sum);
+		std::cout << "1 producer, 1 consumer, " << items << " ints:\n"
+		          << "  mutex + zen::queue: " << time_locked << " seconds\n"
+		          << "  zen::spsc_queue:    " << time_spsc   << " seconds\n";
+	}
+
+	for (const size_t threads : { size_t(2), size_t(4), size_t(16), size_t(64) }) {
+		locked_queue         locked;
+		zen::mpmc_queue<int> mpmc(1024);
+		const double time_locked = run_queue_variant(locked, threads, items, locked_sum);
+		const double time_mpmc   = run_queue_variant(mpmc,   threads, items, lockfree_sum);
+		std::cout << std::setfill(' ') << std::setw(2) << threads << " threads (half producers), " << items << " ints: "
+		          << "mutex + zen::queue " << time_locked << " s, zen::mpmc_queue " << time_mpmc << " s\n";
+	}
+	if (locked_sum != lockfree_sum)
+		std::cout << "(RESULTS DIFFER)\n";
+}
+
+// Fires the earliest of n timers and re-arms it a random delay later, `steps` times,
+// as an event loop or a discrete-event simulation does
+template<class Heap>
+double run_scheduler_variant(const std::vector<uint64_t>& deadlines, const std::vector<uint64_t>& delays, uint64_t& checksum) {
+	Heap timers(deadlines);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const uint64_t delay : delays) {
+		const uint64_t now = timers.top();
+		checksum += now;
+		if constexpr (requires { timers.replace_top(now + delay); }) {
+			timers.replace_top(now + delay);
+		}
+		else {
+			timers.pop();
+			timers.push(now + delay);
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_dary_heap() {
+	const size_t n = 2'000'000;
+	std::mt19937_64 rng(23);
+	std::vector<uint64_t> values(n);
+	for (auto& v : values)
+		v = rng() % 1'000'000'000;
+
+	// Bulk build: what the iterable constructor of zen::priority_queue used to do, then does now
+	auto start = std::chrono::high_resolution_clock::now();
+	std::priority_queue<uint64_t> pushed;
+	for (const uint64_t v : values)
+		pushed.push(v);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_pushed = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	const zen::priority_queue<uint64_t> heapified(values);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_heapified = end - start;
+
+	std::cout << "Build a heap of " << n << " items:\n"
+	          << "  one push() at a time:    " << time_pushed.count()    << " seconds\n"
+	          << "  zen::priority_queue(c):  " << time_heapified.count() << " seconds"
+	          << (pushed.top() == heapified.top() ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// Top-k: keep the 1000 smallest of the stream in a max-heap, replacing its top as smaller ones come
+	const size_t k = 1000;
+	start = std::chrono::high_resolution_clock::now();
+	zen::priority_queue<uint64_t> binary_top(std::vector<uint64_t>(values.begin(), values.begin() + k));
+	for (size_t i = k; i < n; ++i)
+		if (values[i] < binary_top.top()) {
+			binary_top.pop();
+			binary_top.push(values[i]);
+		}
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_binary_top = end - start;
+
+	start = std::chrono::high_resolution_clock::now();
+	zen::dary_heap<uint64_t, 4> dary_top(values.begin(), values.begin() + k);
+	for (size_t i = k; i < n; ++i)
+		if (values[i] < dary_top.top())
+			dary_top.replace_top(values[i]);
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_dary_top = end - start;
+
+	std::cout << "Top " << k << " of " << n << " items:\n"
+	          << "  zen::priority_queue:  " << time_binary_top.count() << " seconds\n"
+	          << "  zen::dary_heap<4>:    " << time_dary_top.count()   << " seconds"
+	          << (binary_top.top() == dary_top.top() ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// Scheduling: 1M pending timers, 2M fire-and-re-arm steps
+	const std::vector<uint64_t> deadlines(values.begin(), values.begin() + n / 2);
+	std::vector<uint64_t> delays(n);
+	for (auto& d : delays)
+		d = 1 + rng() % 1'000'000;
+
+	using min_binary = zen::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>>;
+	uint64_t binary_sum = 0, dary4_sum = 0, dary8_sum = 0;
+	const double time_binary = run_scheduler_variant<min_binary>(deadlines, delays, binary_sum);
+	const double time_dary4  = run_scheduler_variant<zen::dary_heap<uint64_t, 4, std::greater<uint64_t>>>(deadlines, delays, dary4_sum);
+	const double time_dary8  = run_scheduler_variant<zen::dary_heap<uint64_t, 8, std::greater<uint64_t>>>(deadlines, delays, dary8_sum);
+
+	std::cout << "Scheduler, " << deadlines.size() << " timers, " << delays.size() << " steps:\n"
+	          << "  zen::priority_queue (binary heap): " << time_binary << " seconds\n"
+	          << "  zen::dary_heap<4>:                 " << time_dary4  << " seconds\n"
+	          << "  zen::dary_heap<8>:                 " << time_dary8  << " seconds"
+	          << (binary_sum == dary4_sum && binary_sum == dary8_sum ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+// Every allocation made through a counting_allocator, by any container or string
+size_t counted_allocations = 0;
+
+template<class T>
+struct counting_allocator {
+	using value_type = T;
+
+	counting_allocator() = default;
+	template<class U> counting_allocator(const counting_allocator<U>&) {}
+
+	T*   allocate(size_t n)          { ++counted_allocations; return std::allocator<T>().allocate(n); }
+	void deallocate(T* p, size_t n)  { std::allocator<T>().deallocate(p, n); }
+
+	friend bool operator==(const counting_allocator&, const counting_allocator&) { return true; }
+};
+
+using counted_string = std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+// Builds Container from a copy of `strings` twice: the way the zen iterable constructors
+// used to (one copied element at a time), and through the constructor from an rvalue
+template<class Container, class AddOne>
+void run_ingest_variant(const char* name, const std::vector<counted_string>& strings, AddOne add_one) {
+	std::vector<counted_string> source = strings;
+	counted_allocations = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	Container one_by_one;
+	for (const auto& s : source)
+		add_one(one_by_one, s);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_one_by_one = end - start;
+	const size_t allocations_one_by_one = counted_allocations;
+
+	counted_allocations = 0;
+	start = std::chrono::high_resolution_clock::now();
+	Container bulk(std::move(source));
+	end = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> time_bulk = end - start;
+	const size_t allocations_bulk = counted_allocations;
+
+	std::cout << std::setfill(' ') << std::left << std::setw(20) << name << std::right
+	          << " one by one: " << std::setw(7) << allocations_one_by_one << " allocations, " << time_one_by_one.count() << " s;"
+	          << " bulk: "       << std::setw(7) << allocations_bulk       << " allocations, " << time_bulk.count()       << " s"
+	          << (one_by_one.size() == bulk.size() ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void test_bulk_ingest() {
+	const size_t n = 200'000;
+	std::vector<counted_string> strings;
+	for (size_t i = 0; i < n; ++i) // longer than the short-string buffer, so every copy allocates
+		strings.push_back(counted_string("customer-record-") + counted_string(std::to_string(i * 7919).c_str()));
+
+	using alloc = counting_allocator<counted_string>;
+	std::cout << n << " strings, taken from a temporary std::vector:\n";
+	run_ingest_variant<zen::vector<counted_string, alloc>>("zen::vector", strings, [](auto& c, const auto& s) { c.push_back(s); });
+	run_ingest_variant<zen::deque<counted_string, alloc>>("zen::deque", strings, [](auto& c, const auto& s) { c.push_back(s); });
+	run_ingest_variant<zen::queue<counted_string, std::deque<counted_string, alloc>>>("zen::queue", strings, [](auto& c, const auto& s) { c.push(s); });
+	run_ingest_variant<zen::priority_queue<counted_string, std::vector<counted_string, alloc>>>("zen::priority_queue", strings, [](auto& c, const auto& s) { c.push(s); });
+	run_ingest_variant<zen::set<counted_string, std::less<>, alloc>>("zen::set", strings, [](auto& c, const auto& s) { c.insert(s); });
+	run_ingest_variant<zen::unordered_set<counted_string, zen::string_hash, zen::string_equal, alloc>>("zen::unordered_set", strings, [](auto& c, const auto& s) { c.insert(s); });
+}
+
+// Times f() and returns the elapsed seconds
+template<class F>
+double time_seconds(F f) {
+	auto start = std::chrono::high_resolution_clock::now();
+	f();
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration<double>(end - start).count();
+}
+
+void test_point_cloud() {
+	const size_t n = 10'000'000;
+	std::mt19937_64 rng(7);
+	std::uniform_real_distribution<double> coord(-1000.0, 1000.0);
+
+	zen::points3d aos;
+	aos.reserve(n);
+	for (size_t i = 0; i < n; ++i)
+		aos.push_back(zen::point3d(coord(rng), coord(rng), coord(rng)));
+	zen::point_cloud3d soa(aos);
+
+	const zen::point3d offset(1.5, -2.5, 3.5);
+	const double k = 0.5;
+
+	// Every 997th point of the two layouts, compared exactly: both do the same arithmetic in the same order
+	const auto same_points = [](const auto& points, const auto& cloud) {
+		for (size_t i = 0; i < points.size(); i += 997)
+			if (!(points[i] == cloud[i]))
+				return false;
+		return true;
+	};
+
+	const double aos_translate = time_seconds([&] { for (auto& p : aos) { p.x() += offset.x(); p.y() += offset.y(); p.z() += offset.z(); } });
+	const double soa_translate = time_seconds([&] { soa.translate(offset); });
+	const bool same_translate = same_points(aos, soa);
+
+	const double aos_scale = time_seconds([&] { for (auto& p : aos) { p.x() *= k; p.y() *= k; p.z() *= k; } });
+	const double soa_scale = time_seconds([&] { soa.scale(k); });
+	const bool same_scale = same_points(aos, soa);
+
+	// A quarter turn about z, then a shift along it
+	const std::array<std::array<double, 4>, 3> m = { { { 0, -1, 0, 0 }, { 1, 0, 0, 0 }, { 0, 0, 1, 10 } } };
+	const double aos_transform = time_seconds([&] {
+		for (auto& p : aos)
+			p = zen::point3d(m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+			                 m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+			                 m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]);
+	});
+	const double soa_transform = time_seconds([&] { soa.transform(m); });
+	const bool same_transform = same_points(aos, soa);
+
+	zen::point3d aos_centroid(0, 0, 0), soa_centroid(0, 0, 0);
+	const double aos_centroid_time = time_seconds([&] {
+		double sx = 0, sy = 0, sz = 0;
+		for (const auto& p : aos) { sx += p.x(); sy += p.y(); sz += p.z(); }
+		aos_centroid = zen::point3d(sx / n, sy / n, sz / n);
+	});
+	const double soa_centroid_time = time_seconds([&] { soa_centroid = soa.centroid(); });
+
+	std::pair<zen::point3d, zen::point3d> aos_box, soa_box;
+	const double aos_box_time = time_seconds([&] {
+		zen::point3d lo = aos[0], hi = aos[0];
+		for (const auto& p : aos) {
+			lo = zen::point3d(std::min(lo.x(), p.x()), std::min(lo.y(), p.y()), std::min(lo.z(), p.z()));
+			hi = zen::point3d(std::max(hi.x(), p.x()), std::max(hi.y(), p.y()), std::max(hi.z(), p.z()));
+		}
+		aos_box = { lo, hi };
+	});
+	const double soa_box_time = time_seconds([&] { soa_box = soa.bounding_box(); });
+
+	// The two centroids add the same values in a different order, so they agree only up to rounding
+	const auto close = [](double a, double b) { return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(a)); };
+	const bool same_centroid = close(aos_centroid.x(), soa_centroid.x()) && close(aos_centroid.y(), soa_centroid.y()) && close(aos_centroid.z(), soa_centroid.z());
+
+	std::cout << n << " points, zen::points3d (array of structures) vs zen::point_cloud3d (structure of arrays):\n"
+	          << "  translate:    " << aos_translate     << " vs " << soa_translate     << " seconds" << (same_translate ? "" : " (RESULTS DIFFER)") << "\n"
+	          << "  scale:        " << aos_scale         << " vs " << soa_scale         << " seconds" << (same_scale     ? "" : " (RESULTS DIFFER)") << "\n"
+	          << "  transform:    " << aos_transform     << " vs " << soa_transform     << " seconds" << (same_transform ? "" : " (RESULTS DIFFER)") << "\n"
+	          << "  centroid:     " << aos_centroid_time << " vs " << soa_centroid_time << " seconds" << (same_centroid ? "" : " (RESULTS DIFFER)") << "\n"
+	          << "  bounding box: " << aos_box_time      << " vs " << soa_box_time      << " seconds" << (aos_box == soa_box ? "" : " (RESULTS DIFFER)") << "\n";
+
+	// The same in the plane, on a copy of the x and y coordinates
+	zen::points2d aos2d;
+	aos2d.reserve(n);
+	for (const auto& p : aos)
+		aos2d.push_back(zen::point2d(p.x(), p.y()));
+	zen::point_cloud2d soa2d(aos2d);
+
+	const std::array<std::array<double, 3>, 2> m2d = { { { 0.5, -0.5, 1 }, { 0.5, 0.5, -1 } } };
+	const double aos2d_time = time_seconds([&] {
+		for (auto& p : aos2d)
+			p = zen::point2d(p.x() * k, p.y() * k);
+		for (auto& p : aos2d)
+			p = zen::point2d(m2d[0][0] * p.x() + m2d[0][1] * p.y() + m2d[0][2], m2d[1][0] * p.x() + m2d[1][1] * p.y() + m2d[1][2]);
+	});
+	const double soa2d_time = time_seconds([&] { soa2d.scale(k).transform(m2d); });
+
+	std::cout << n << " points, zen::points2d vs zen::point_cloud2d:\n"
+	          << "  scale + transform: " << aos2d_time << " vs " << soa2d_time << " seconds" << (same_points(aos2d, soa2d) ? "" : " (RESULTS DIFFER)") << "\n";
+}
+
+void pointer_dereference(int** matrix, int rows, int cols) {
+	long long sum = 0;
+	for (int i = 0; i < rows; ++i)
+		for (int j = 0; j < cols; ++j)
+			sum += *(*(matrix + i) + j);
+}
+
+void pointer_elimination(int** matrix, int rows, int cols) {
+	long long sum = 0;
+	for (int i = 0; i < rows; ++i) {
+		int* row_ptr = matrix[i];
+		for (int j = 0; j < cols; ++j)
+			sum += row_ptr[j];
+	}
+}
+
+void test_pointer_elimination() {
+	const int rows = 1000;
+	const int cols = 1000;
+
+	int** matrix = new int*[rows];
+	for (int i = 0; i < rows; ++i) {
+		matrix[i] = new int[cols];
+		for (int j = 0; j < cols; ++j)
+			matrix[i][j] = i + j;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	pointer_dereference(matrix, rows, cols);
+	auto end = std::chrono::high_resolution_clock::now();
+	std::cout << "Pointer dereference time: " << std::chrono::duration<double>(end - start).count() << " s\n";
+
+	start = std::chrono::high_resolution_clock::now();
+	pointer_elimination(matrix, rows, cols);
+	end = std::chrono::high_resolution_clock::now();
+	std::cout << "Pointer elimination time: " << std::chrono::duration<double>(end - start).count() << " s\n";
+
+	for (int i = 0; i < rows; ++i)
+		delete[] matrix[i];
+	delete[] matrix;
+}
+
+void test_fragmentation(size_t iterations, size_t max_block_size) {
+	std::vector<char*> blocks;
+	blocks.reserve(iterations);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (size_t i = 0; i < iterations; ++i) {
+		size_t sz = 1 + std::rand() % max_block_size;
+		blocks.push_back(new char[sz]);
+		if (i % 10 == 0 && !blocks.empty()) {
+			size_t idx = std::rand() % blocks.size();
+			delete[] blocks[idx];
+			blocks.erase(blocks.begin() + idx);
+		}
+	}
+
+	for (auto ptr : blocks) {
+		delete[] ptr;
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "Fragmentation test done in "
+		<< std::chrono::duration<double>(end - start).count()
+		<< " seconds\n";
+}
+
+void test_contiguous_allocation(size_t iterations, size_t block_size) {
+	std::vector<char> memory_pool(iterations * block_size);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	long long sum = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		char* block = memory_pool.data() + (i * block_size);
+		for (size_t j = 0; j < block_size; ++j) {
+			block[j] = static_cast<char>(j);
+			sum += block[j];
+		}
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	std::cout << "Contiguous allocation test done in "
+		<< std::chrono::duration<double>(end - start).count()
+		<< " seconds\n";
+}
+
+int main()
+{
+	print_header("Performance Optimization Tests");
+	test_optimization();
+
+	print_header("Inline vs No Inline Tests");
+	test_inline_vs_no_inline();
+
+	print_header("Loop Unrolling Tests");
+	test_loop_unrolling();
+
+	print_header("Short-String Optimization Tests");
 	test_sso_performance();
 
 	print_header("Virtual vs Direct Call Tests");
@@ -337,6 +2418,80 @@ int main()
 	print_header("Algorithmic Optimization Tests");
 	test_algorithmic_optimization();
 
+	print_header("Expression Template Tests");
+	test_expression_templates();
+
+	print_header("Runtime CPU Dispatch Tests");
+	test_runtime_dispatch();
+
+	print_header("Branch Prediction Tests");
+	test_branch_prediction();
+
+	print_header("String Classification Tests");
+	test_string_classification();
+
+	print_header("Case Conversion Tests");
+	test_case_conversion();
+
+	print_header("Replace All Tests");
+	test_replace_all();
+
+	print_header("Zero-Copy Split Tests");
+	test_split_views();
+
+	print_header("Regex Cache Tests");
+	test_regex_cache();
+
+	print_header("Pattern Scanner Tests");
+	test_pattern_scanners();
+
+#if ZEN_HAS_CT_REGEX
+	print_header("Compile-Time Regex Tests");
+	test_compile_time_regex();
+#endif
+
+	print_header("Version Parsing Tests");
+	test_version_parsing();
+
+	print_header("Format Into Buffer Tests");
+	test_format_into();
+
+	print_header("Async Logging Tests");
+	test_async_logging();
+
+	print_header("Binary Serialization Tests");
+	test_binary_serialization();
+
+	print_header("Flat Hash Map Tests");
+	test_flat_hash_map();
+
+	print_header("Transparent Lookup Tests");
+	test_transparent_lookup();
+
+	print_header("Fast Hash Tests");
+	test_fast_hash();
+
+	print_header("Flat Sorted Container Tests");
+	test_flat_containers();
+
+	print_header("Small Vector Tests");
+	test_small_vector();
+
+	print_header("SIMD Linear Search Tests");
+	test_simd_linear_search();
+
+	print_header("Concurrent Queue Tests");
+	test_concurrent_queues();
+
+	print_header("D-ary Heap Tests");
+	test_dary_heap();
+
+	print_header("Bulk Ingest Tests");
+	test_bulk_ingest();
+
+	print_header("Point Cloud Tests");
+	test_point_cloud();
+
 	print_header("Pointer Dereference vs Elimination Tests");
 	test_pointer_elimination();
 